@@ -19,12 +19,13 @@
 #include <assert.h>
 #include <stdint.h>
 
-#ifdef USE_PEXT
-#include <immintrin.h>
+#if defined(__x86_64__)
+    #include <immintrin.h>
 #endif
 
 #include "attacks.h"
 #include "bitboards.h"
+#include "cpu.h"
 #include "types.h"
 
 
@@ -34,6 +35,11 @@ uint64_t BishopAttacks[0x1480];
 uint64_t RookAttacks[0x19000];
 uint64_t KingAttacks[SQUARE_NB];
 
+// With PEXT, each attack set is itself compressed against the empty board
+// attacks, and expanded with PDEP. This cuts the tables to a quarter size
+uint16_t BishopAttacksPEXT[0x1480];
+uint16_t RookAttacksPEXT[0x19000];
+
 Magic BishopTable[SQUARE_NB];
 Magic RookTable[SQUARE_NB];
 
@@ -49,13 +55,19 @@ static void setSquare(uint64_t *bb, int rank, int file){
 }
 
 static int sliderIndex(uint64_t occupied, Magic *table) {
-#ifdef USE_PEXT
-    return _pext_u64(occupied, table->mask);
-#else
     return ((occupied & table->mask) * table->magic) >> table->shift;
-#endif
 }
 
+// PEXT and PDEP only exist on x86-64. Other processors never set
+// CPUHasFastPEXT, and always use the magic bitboards
+
+#if defined(__x86_64__)
+__attribute__((target("bmi2")))
+static uint64_t sliderAttacksPEXT(uint64_t occupied, Magic *table) {
+    return _pdep_u64(table->offsetPEXT[_pext_u64(occupied, table->mask)], table->attacks);
+}
+#endif
+
 static uint64_t sliderAttacks(int sq, uint64_t occupied, const int delta[4][2]) {
 
     int rank, file, dr, df;
@@ -78,6 +90,23 @@ static uint64_t sliderAttacks(int sq, uint64_t occupied, const int delta[4][2])
     return result;
 }
 
+#if defined(__x86_64__)
+__attribute__((target("bmi2")))
+static void initSliderAttacksPEXT(int sq, Magic *table, const int delta[4][2]) {
+
+    uint64_t occupied = 0ull;
+
+    if (sq != SQUARE_NB - 1)
+        table[sq+1].offsetPEXT = table[sq].offsetPEXT + (1 << popcount(table[sq].mask));
+
+    do {
+        int index = _pext_u64(occupied, table[sq].mask);
+        table[sq].offsetPEXT[index] = _pext_u64(sliderAttacks(sq, occupied, delta), table[sq].attacks);
+        occupied = (occupied - table[sq].mask) & table[sq].mask;
+    } while (occupied);
+}
+#endif
+
 static void initSliderAttacks(int sq, Magic *table, uint64_t magic, const int delta[4][2]) {
 
     const uint64_t edges = ((RANK_1 | RANK_8) & ~Ranks[rankOf(sq)])
@@ -85,9 +114,18 @@ static void initSliderAttacks(int sq, Magic *table, uint64_t magic, const int de
 
     uint64_t occupied = 0ull;
 
-    table[sq].magic = magic;
-    table[sq].mask  = sliderAttacks(sq, 0, delta) & ~edges;
-    table[sq].shift = 64 - popcount(table[sq].mask);
+    table[sq].magic   = magic;
+    table[sq].attacks = sliderAttacks(sq, 0, delta);
+    table[sq].mask    = table[sq].attacks & ~edges;
+    table[sq].shift   = 64 - popcount(table[sq].mask);
+
+    // Only one of the two layouts is ever used, so only one is built
+#if defined(__x86_64__)
+    if (CPUHasFastPEXT) {
+        initSliderAttacksPEXT(sq, table, delta);
+        return;
+    }
+#endif
 
     if (sq != SQUARE_NB - 1)
         table[sq+1].offset = table[sq].offset + (1 << popcount(table[sq].mask));
@@ -110,6 +148,8 @@ void initAttacks() {
     // First square has initial offset
     BishopTable[0].offset = BishopAttacks;
     RookTable[0].offset = RookAttacks;
+    BishopTable[0].offsetPEXT = BishopAttacksPEXT;
+    RookTable[0].offsetPEXT = RookAttacksPEXT;
 
     // Init attack tables for Pawns
     for (int sq = 0; sq < 64; sq++) {
@@ -147,11 +187,17 @@ uint64_t knightAttacks(int sq) {
 
 uint64_t bishopAttacks(int sq, uint64_t occupied) {
     assert(0 <= sq && sq < SQUARE_NB);
+#if defined(__x86_64__)
+    if (CPUHasFastPEXT) return sliderAttacksPEXT(occupied, &BishopTable[sq]);
+#endif
     return BishopTable[sq].offset[sliderIndex(occupied, &BishopTable[sq])];
 }
 
 uint64_t rookAttacks(int sq, uint64_t occupied) {
     assert(0 <= sq && sq < SQUARE_NB);
+#if defined(__x86_64__)
+    if (CPUHasFastPEXT) return sliderAttacksPEXT(occupied, &RookTable[sq]);
+#endif
     return RookTable[sq].offset[sliderIndex(occupied, &RookTable[sq])];
 }
 
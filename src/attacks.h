@@ -26,7 +26,9 @@ struct Magic {
     uint64_t magic;
     uint64_t mask;
     uint64_t shift;
+    uint64_t attacks;
     uint64_t *offset;
+    uint16_t *offsetPEXT;
 };
 
 void initAttacks();
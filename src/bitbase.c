@@ -0,0 +1,186 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "attacks.h"
+#include "bitbase.h"
+#include "bitboards.h"
+#include "masks.h"
+#include "types.h"
+
+enum { KPK_INVALID, KPK_UNKNOWN, KPK_DRAW, KPK_WIN };
+
+// One bit per position, set when White (with the Pawn) is winning
+static uint32_t KPKBitbase[KPK_POSITIONS / 32];
+
+static int indexKPK(int turn, int wking, int bking, int pawn) {
+
+    // Pawns are limited to the A-D files, and to the 2nd through 7th ranks
+    int pawnIndex = 4 * (rankOf(pawn) - 1) + fileOf(pawn);
+
+    assert(0 <= pawnIndex && pawnIndex < KPK_PAWNS);
+    return ((pawnIndex * 64 + wking) * 64 + bking) * 2 + turn;
+}
+
+static int initialKPK(int turn, int wking, int bking, int pawn) {
+
+    int promote = pawn + 8;
+
+    // Kings may not touch, nor sit on the Pawn. White may not move while
+    // the Black King is in check, as that position cannot be reached
+    if (   distanceBetween(wking, bking) <= 1
+        || wking == pawn || bking == pawn
+        || (turn == WHITE && testBit(pawnAttacks(WHITE, pawn), bking)))
+        return KPK_INVALID;
+
+    // White promotes the Pawn, which can not be taken immediately
+    if (   turn == WHITE
+        && rankOf(pawn) == 6
+        && wking != promote && bking != promote
+        && (    distanceBetween(bking, promote) > 1
+            ||  distanceBetween(wking, promote) == 1))
+        return KPK_WIN;
+
+    // Black is stalemated, or simply captures an undefended Pawn
+    if (   turn == BLACK
+        && (   !(kingAttacks(bking) & ~(kingAttacks(wking) | pawnAttacks(WHITE, pawn)))
+            ||  (testBit(kingAttacks(bking), pawn) && !testBit(kingAttacks(wking), pawn))))
+        return KPK_DRAW;
+
+    return KPK_UNKNOWN;
+}
+
+static int classifyKPK(uint8_t *db, int turn, int wking, int bking, int pawn) {
+
+    // White needs a single winning move, and Black needs a single drawing
+    // move. A position is resolved the other way once every move is known
+    int good = turn == WHITE ? KPK_WIN : KPK_DRAW;
+    int bad  = turn == WHITE ? KPK_DRAW : KPK_WIN;
+    int unknown = 0, result;
+
+    uint64_t moves = turn == WHITE
+                   ? kingAttacks(wking) & ~kingAttacks(bking)
+                   : kingAttacks(bking) & ~(kingAttacks(wking) | pawnAttacks(WHITE, pawn));
+
+    while (moves) {
+
+        int sq = poplsb(&moves);
+
+        result = turn == WHITE ? db[indexKPK(BLACK, sq, bking, pawn)]
+                               : db[indexKPK(WHITE, wking, sq, pawn)];
+
+        if (result == good) return good;
+        unknown |= result == KPK_UNKNOWN;
+    }
+
+    // Pawn pushes, where promotions were already resolved as wins
+    if (turn == WHITE && rankOf(pawn) < 6
+        && wking != pawn + 8 && bking != pawn + 8) {
+
+        result = db[indexKPK(BLACK, wking, bking, pawn + 8)];
+        if (result == good) return good;
+        unknown |= result == KPK_UNKNOWN;
+
+        if (   rankOf(pawn) == 1
+            && wking != pawn + 16 && bking != pawn + 16) {
+
+            result = db[indexKPK(BLACK, wking, bking, pawn + 16)];
+            if (result == good) return good;
+            unknown |= result == KPK_UNKNOWN;
+        }
+    }
+
+    return unknown ? KPK_UNKNOWN : bad;
+}
+
+void initKPK() {
+
+    int idx, size, remaining, progress, turn, wking, bking;
+    uint16_t unknown[2 * SQUARE_NB * SQUARE_NB];
+    uint8_t *db = calloc(KPK_POSITIONS, sizeof(uint8_t));
+
+    // A position only depends on others with the same Pawn square, or with the
+    // Pawn further advanced. Solving each Pawn square in turn, starting from the
+    // 7th rank, keeps every pass of the retrograde analysis within a small table
+    for (int pawn = 55; pawn >= 8; pawn--) {
+
+        if (fileOf(pawn) >= 4) continue;
+
+        // Resolve every position that can be decided without a search,
+        // and collect the rest as (turn, white king, black king) triplets
+        for (size = 0, wking = 0; wking < SQUARE_NB; wking++) {
+            for (bking = 0; bking < SQUARE_NB; bking++) {
+                for (turn = WHITE; turn <= BLACK; turn++) {
+                    idx = indexKPK(turn, wking, bking, pawn);
+                    db[idx] = initialKPK(turn, wking, bking, pawn);
+                    if (db[idx] == KPK_UNKNOWN)
+                        unknown[size++] = (turn << 12) | (wking << 6) | bking;
+                }
+            }
+        }
+
+        // Repeat until no unresolved position changes its result, while
+        // dropping each position from the list as soon as it is resolved
+        do {
+
+            remaining = 0;
+
+            for (int i = 0; i < size; i++) {
+
+                turn  = unknown[i] >> 12;
+                wking = (unknown[i] >> 6) & 63;
+                bking = unknown[i] & 63;
+                idx   = indexKPK(turn, wking, bking, pawn);
+
+                db[idx] = classifyKPK(db, turn, wking, bking, pawn);
+                if (db[idx] == KPK_UNKNOWN)
+                    unknown[remaining++] = unknown[i];
+            }
+
+            progress = remaining != size;
+            size = remaining;
+
+        } while (progress && size);
+    }
+
+    // Compress into a single bit per position, where anything unresolved is a draw
+    for (idx = 0; idx < KPK_POSITIONS; idx++)
+        if (db[idx] == KPK_WIN)
+            KPKBitbase[idx / 32] |= 1u << (idx % 32);
+
+    free(db);
+}
+
+int probeKPK(int strong, int strongKing, int pawn, int weakKing, int turn) {
+
+    // Treat the strong side as White, by flipping the board vertically
+    if (strong == BLACK) {
+        strongKing ^= 56, pawn ^= 56, weakKing ^= 56;
+        turn = !turn;
+    }
+
+    // Treat the Pawn as being on the A-D files, by flipping horizontally
+    if (fileOf(pawn) >= 4)
+        strongKing ^= 7, pawn ^= 7, weakKing ^= 7;
+
+    int idx = indexKPK(turn, strongKing, weakKing, pawn);
+    return (KPKBitbase[idx / 32] >> (idx % 32)) & 1;
+}
@@ -63,10 +63,6 @@ int backmost(int c, uint64_t b) {
     return c == WHITE ? getlsb(b) : getmsb(b);
 }
 
-int popcount(uint64_t b) {
-    return __builtin_popcountll(b);
-}
-
 int getlsb(uint64_t b) {
     assert(b);  // lsb(0) is undefined
     return __builtin_ctzll(b);
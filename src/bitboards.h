@@ -63,7 +63,6 @@ int square(int r, int f);
 int frontmost(int c, uint64_t b);
 int backmost(int c, uint64_t b);
 
-int popcount(uint64_t b);
 int getlsb(uint64_t b);
 int getmsb(uint64_t b);
 int poplsb(uint64_t *b);
@@ -75,3 +74,9 @@ void clearBit(uint64_t *b, int i);
 bool testBit(uint64_t b, int i);
 
 void printBitboard(uint64_t b);
+
+// Defined here so that it is always inlined. Each MULTIVERSION clone of a
+// caller then counts bits with the best instruction available to that clone
+static inline int popcount(uint64_t b) {
+    return __builtin_popcountll(b);
+}
@@ -27,7 +27,9 @@
 #include "bitboards.h"
 #include "board.h"
 #include "castle.h"
+#include "evaluate.h"
 #include "masks.h"
+#include "material.h"
 #include "psqt.h"
 #include "search.h"
 #include "time.h"
@@ -37,6 +39,7 @@
 #include "types.h"
 #include "move.h"
 #include "movegen.h"
+#include "movepicker.h"
 #include "zobrist.h"
 
 const char *PieceLabel[COLOUR_NB] = {"PNBRQK", "pnbrqk"};
@@ -63,6 +66,7 @@ static void setSquare(Board *board, int colour, int piece, int sq) {
     setBit(&board->pieces[piece], sq);
 
     board->psqtmat += PSQT[board->squares[sq]][sq];
+    board->matkey += MaterialKeys[board->squares[sq]];
     board->hash ^= ZobristKeys[board->squares[sq]][sq];
     if (piece == PAWN || piece == KING)
         board->pkhash ^= ZobristKeys[board->squares[sq]][sq];
@@ -140,9 +144,6 @@ void boardFromFEN(Board *board, const char *fen) {
     // 50 move counter
     board->fiftyMoveRule = atoi(strtok_r(NULL, " ", &strPos));
 
-    // Move count: ignore and use zero, as we count since root
-    board->numMoves = 0;
-
     // Need king attackers for move generation
     board->kingAttackers = attackersToKingSquare(board);
 
@@ -237,35 +238,13 @@ void printBoard(Board *board) {
     printf("\n%s\n\n", fen);
 }
 
-uint64_t perft(Board *board, int depth){
-
-    Undo undo[1];
-    int size = 0;
-    uint64_t found = 0ull;
-    uint16_t moves[MAX_MOVES];
-
-    if (depth == 0) return 1ull;
-
-    genAllMoves(board, moves, &size);
-
-    // Recurse on all valid moves
-    for(size -= 1; size >= 0; size--){
-        applyMove(board, moves[size], undo);
-        if (isNotInCheck(board, !board->turn))
-            found += perft(board, depth-1);
-        revertMove(board, moves[size], undo);
-    }
-
-    return found;
-}
-
 void runBenchmark(Thread *threads, int depth) {
 
     double start, end;
     Board board;
     Limits limits;
     uint16_t bestMove, ponderMove;
-    uint64_t nodes = 0ull;
+    uint64_t nodes = 0ull, pkhits = 0ull, pkprobes = 0ull;
 
     // Initialize limits for the search
     limits.limitedByNone  = 0;
@@ -283,9 +262,14 @@ void runBenchmark(Thread *threads, int depth) {
         boardFromFEN(&board, Benchmarks[i]);
 
         limits.start = getRealTime();
-        getBestMove(threads, &board, &limits, &bestMove, &ponderMove);
+        getBestMove(threads, &board, NULL, 0, &limits, &bestMove, &ponderMove);
         nodes += nodesSearchedThreadPool(threads);
 
+        for (int j = 0; j < threads[0].nthreads; j++) {
+            pkhits   += threads[j].pktable.hits;
+            pkprobes += threads[j].pktable.probes;
+        }
+
         clearTT(); // Reset TT for new search
     }
 
@@ -295,13 +279,74 @@ void runBenchmark(Thread *threads, int depth) {
     printf("Time  : %dms\n", (int)(end - start));
     printf("Nodes : %"PRIu64"\n", nodes);
     printf("NPS   : %d\n", (int)(nodes / ((end - start) / 1000.0)));
+    printf("PKHit : %.2f%%\n", pkprobes ? 100.0 * pkhits / pkprobes : 0.0);
 }
 
-int boardIsDrawn(Board *board, int height) {
+void runEvalBenchmark(int iterations) {
+
+    double start, end;
+    Board board;
+    EvalInfo ei;
+    uint64_t calls = 0ull;
+    volatile int sink = 0;
+
+    start = getRealTime();
+
+    // Repeatedly evaluate each benchmark position, without any caching
+    for (int i = 0; strcmp(Benchmarks[i], ""); i++) {
+        boardFromFEN(&board, Benchmarks[i]);
+
+        for (int j = 0; j < iterations; j++, calls++) {
+            initializeEvalInfo(&ei, &board, NULL);
+            sink += evaluatePieces(&ei, &board);
+        }
+    }
+
+    end = getRealTime();
+
+    printf("Time  : %dms\n", (int)(end - start));
+    printf("Calls : %"PRIu64"\n", calls);
+    printf("ns/op : %.1f\n", (end - start) * 1e6 / calls);
+}
+
+void runMovePickerBenchmark(Thread *thread, int iterations) {
+
+    double start, end;
+    MovePicker mp;
+    uint64_t picked = 0ull;
+    Board *board = &thread->board;
+
+    // Fill the history table with noise, so that the quiets must be ordered
+    for (int colour = 0; colour < COLOUR_NB; colour++)
+        for (int from = 0; from < SQUARE_NB; from++)
+            for (int to = 0; to < SQUARE_NB; to++)
+                thread->history[colour][from][to] = (int)(rand64() % 32769) - 16384;
+
+    start = getRealTime();
+
+    // Repeatedly pick every move from each benchmark position, in order
+    for (int i = 0; strcmp(Benchmarks[i], ""); i++) {
+        boardFromFEN(board, Benchmarks[i]);
+
+        for (int j = 0; j < iterations; j++) {
+            initMovePicker(&mp, thread, NONE_MOVE, 0);
+            while (selectNextMove(&mp, board, 0) != NONE_MOVE)
+                picked++;
+        }
+    }
+
+    end = getRealTime();
+
+    printf("Time  : %dms\n", (int)(end - start));
+    printf("Moves : %"PRIu64"\n", picked);
+    printf("ns/op : %.1f\n", (end - start) * 1e6 / picked);
+}
+
+int boardIsDrawn(Board *board, uint64_t *history, int height) {
 
     // Drawn if any of the three possible cases
     return drawnByFiftyMoveRule(board)
-        || drawnByRepetition(board, height)
+        || drawnByRepetition(board, history, height)
         || drawnByInsufficientMaterial(board);
 }
 
@@ -313,21 +358,47 @@ int drawnByFiftyMoveRule(Board *board) {
     return board->fiftyMoveRule > 99;
 }
 
-int drawnByRepetition(Board *board, int height) {
+int drawnByRepetition(Board *board, uint64_t *history, int height) {
 
     int reps = 0;
 
-    // Look through hash histories for our moves
-    for (int i = board->numMoves - 2; i >= 0; i -= 2) {
+    // The history is indexed by height, with the game moves played before
+    // the root at negative heights. A fifty move counter of 100 or more is
+    // already a draw, so we never look back further than MAX_HISTORY
+    assert(board->fiftyMoveRule < 100);
 
-        // No draw can occur before a zeroing move
-        if (i < board->numMoves - board->fiftyMoveRule)
-            break;
+    // Look through hash histories for our moves
+    for (int i = height - 2; i >= height - board->fiftyMoveRule; i -= 2) {
 
         // Check for matching hash with a two fold after the root,
         // or a three fold which occurs in part before the root move
-        if (    board->history[i] == board->hash
-            && (i > board->numMoves - height || ++reps == 2))
+        if (history[i] == board->hash && (i > 0 || ++reps == 2))
+            return 1;
+    }
+
+    return 0;
+}
+
+int upcomingRepetition(Board *board, uint64_t *history, int height) {
+
+    const uint64_t occupied = board->colours[WHITE] | board->colours[BLACK];
+    const int end = MIN(MIN(board->fiftyMoveRule, board->pliesFromNull), height - 1);
+
+    // Look at earlier positions in the tree with the other side to move. If
+    // one differs from ours by a single reversible move, taken from the
+    // Cuckoo tables, and nothing blocks that move, then it can be repeated.
+    // We never look past a null move, since it can't be played on the board
+    for (int i = 3; i <= end; i += 2) {
+
+        uint64_t moveKey = board->hash ^ history[height - i];
+        int index = CuckooH1(moveKey);
+
+        if (    CuckooKeys[index] != moveKey
+            &&  CuckooKeys[index = CuckooH2(moveKey)] != moveKey)
+            continue;
+
+        uint16_t move = CuckooMoves[index];
+        if (!(bitsBetweenMasks(MoveFrom(move), MoveTo(move)) & occupied))
             return 1;
     }
 
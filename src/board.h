@@ -28,23 +28,25 @@ struct Board {
     uint64_t colours[3];
     uint64_t hash;
     uint64_t pkhash;
+    uint64_t matkey;
     uint64_t kingAttackers;
     int turn;
     int castleRights;
     int epSquare;
     int fiftyMoveRule;
+    int pliesFromNull;
     int psqtmat;
-    int numMoves;
-    uint64_t history[512];
 };
 
 struct Undo {
     uint64_t hash;
     uint64_t pkhash;
+    uint64_t matkey;
     uint64_t kingAttackers;
     int castleRights;
     int epSquare;
     int fiftyMoveRule;
+    int pliesFromNull;
     int psqtmat;
     int capturePiece;
 };
@@ -55,10 +57,12 @@ void boardFromFEN(Board *board, const char *fen);
 void boardToFEN(Board *board, char *fen);
 
 void printBoard(Board *board);
-uint64_t perft(Board *board, int depth);
 void runBenchmark(Thread *threads, int depth);
+void runEvalBenchmark(int iterations);
+void runMovePickerBenchmark(Thread *thread, int iterations);
 
-int boardIsDrawn(Board *board, int height);
+int boardIsDrawn(Board *board, uint64_t *history, int height);
 int drawnByFiftyMoveRule(Board *board);
-int drawnByRepetition(Board *board, int height);
+int drawnByRepetition(Board *board, uint64_t *history, int height);
+int upcomingRepetition(Board *board, uint64_t *history, int height);
 int drawnByInsufficientMaterial(Board *board);
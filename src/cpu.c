@@ -0,0 +1,85 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+#endif
+
+#include "cpu.h"
+
+int CPUHasFastPEXT; // PEXT and PDEP are supported, and not microcoded
+
+char CPUPathName[64]; // Selected code path, as reported in "id name"
+
+#if defined(__x86_64__)
+
+static int cpuFamily() {
+
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    // The extended family is only used when the base family is 0xF
+    return ((eax >> 8) & 0xF) == 0xF ? 0xF + ((eax >> 20) & 0xFF)
+                                     : ((eax >> 8) & 0xF);
+}
+
+#endif
+
+void initCPU() {
+
+    // Detection relies on CPUID. Other processors run the generic code,
+    // with magic bitboards for the sliders, and report it as such
+#if defined(__x86_64__) || defined(__i386__)
+
+    __builtin_cpu_init();
+
+    // AMD processors before Zen 3 (family 0x19) implement PEXT and PDEP
+    // in microcode, taking hundreds of cycles, so magics are faster there.
+    // The 64-bit PEXT used by the slider attacks needs an x86-64 build
+#if defined(__x86_64__)
+    CPUHasFastPEXT =  __builtin_cpu_supports("bmi2")
+                  && !(__builtin_cpu_is("amd") && cpuFamily() < 0x19);
+#endif
+
+#endif
+
+    // Report the MULTIVERSION clone which the loader will select, using
+    // the same instruction set levels as the target_clones in cpu.h
+#if defined(USE_MULTIVERSION)
+    strcpy(CPUPathName, __builtin_cpu_supports("x86-64-v4") ? "AVX512"
+                      : __builtin_cpu_supports("x86-64-v3") ? "AVX2"
+                      : __builtin_cpu_supports("popcnt") ? "POPCNT" : "GENERIC");
+
+    // Without clones, the instruction set was fixed when building
+#elif defined(__AVX512F__)
+    strcpy(CPUPathName, "AVX512");
+#elif defined(__AVX2__)
+    strcpy(CPUPathName, "AVX2");
+#elif defined(__POPCNT__)
+    strcpy(CPUPathName, "POPCNT");
+#else
+    strcpy(CPUPathName, "GENERIC");
+#endif
+
+    if (CPUHasFastPEXT)
+        strcat(CPUPathName, " PEXT");
+}
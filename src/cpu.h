@@ -0,0 +1,37 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Hot paths are compiled once for each level of the instruction set, and the
+// loader resolves each call to the best version for the running processor.
+// This requires ifunc support, and is pointless when the build itself has
+// targeted a modern processor, as with the -march=native builds
+
+#if defined(__x86_64__) && defined(__ELF__) && !defined(__AVX2__)
+    #define USE_MULTIVERSION
+    #define MULTIVERSION __attribute__((target_clones( \
+        "default", "popcnt", "arch=x86-64-v3", "arch=x86-64-v4")))
+#else
+    #define MULTIVERSION
+#endif
+
+extern int CPUHasFastPEXT;
+extern char CPUPathName[64];
+
+void initCPU();
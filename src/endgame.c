@@ -0,0 +1,197 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "bitbase.h"
+#include "bitboards.h"
+#include "board.h"
+#include "endgame.h"
+#include "evaluate.h"
+#include "masks.h"
+#include "types.h"
+
+// Drive the losing King towards the edges and corners of the board
+static const int PushToEdges[SQUARE_NB] = {
+    100,  90,  80,  70,  70,  80,  90, 100,
+     90,  70,  60,  50,  50,  60,  70,  90,
+     80,  60,  40,  30,  30,  40,  60,  80,
+     70,  50,  30,  20,  20,  30,  50,  70,
+     70,  50,  30,  20,  20,  30,  50,  70,
+     80,  60,  40,  30,  30,  40,  60,  80,
+     90,  70,  60,  50,  50,  60,  70,  90,
+    100,  90,  80,  70,  70,  80,  90, 100,
+};
+
+// Drive the losing King towards A1 or H8, the corners of the dark squares
+static const int PushToCorners[SQUARE_NB] = {
+    200, 190, 180, 170, 160, 150, 140, 130,
+    190, 180, 170, 160, 150, 140, 130, 140,
+    180, 170, 155, 140, 140, 125, 140, 150,
+    170, 160, 140, 120, 110, 140, 150, 160,
+    160, 150, 140, 110, 120, 140, 160, 170,
+    150, 140, 125, 140, 140, 155, 170, 180,
+    140, 130, 140, 150, 160, 170, 180, 190,
+    130, 140, 150, 160, 170, 180, 190, 200,
+};
+
+// Bring pieces closer together or further apart, indexed by distance
+static const int PushClose[8] = { 0, 0, 100, 80, 60, 40, 20, 10 };
+static const int PushAway [8] = { 0, 5,  20, 40, 60, 80, 90, 100 };
+
+static int hasOnly(int counts[KING], int pawns, int knights, int bishops, int rooks, int queens) {
+    return counts[PAWN  ] == pawns
+        && counts[KNIGHT] == knights
+        && counts[BISHOP] == bishops
+        && counts[ROOK  ] == rooks
+        && counts[QUEEN ] == queens;
+}
+
+static int relativeSquare(int colour, int sq) {
+    return colour == WHITE ? sq : sq ^ 56;
+}
+
+EndgameFunction lookupEndgame(int counts[COLOUR_NB][KING], int strong) {
+
+    int *us = counts[strong], *them = counts[!strong];
+
+    // Endings where the weak side has material, and the strong side a single piece
+    if (hasOnly(us, 0, 0, 0, 1, 0) && hasOnly(them, 1, 0, 0, 0, 0)) return evaluateKRKP;
+    if (hasOnly(us, 0, 0, 0, 1, 0) && hasOnly(them, 0, 0, 1, 0, 0)) return evaluateKRKB;
+    if (hasOnly(us, 0, 0, 0, 1, 0) && hasOnly(them, 0, 1, 0, 0, 0)) return evaluateKRKN;
+    if (hasOnly(us, 0, 0, 0, 0, 1) && hasOnly(them, 0, 0, 0, 1, 0)) return evaluateKQKR;
+
+    // Everything else requires the weak side to have only a King
+    if (!hasOnly(them, 0, 0, 0, 0, 0)) return NULL;
+
+    if (hasOnly(us, 1, 0, 0, 0, 0)) return evaluateKPK;
+    if (hasOnly(us, 0, 1, 1, 0, 0)) return evaluateKBNK;
+
+    // Any major piece will be enough to mate a lone King
+    if (us[ROOK] || us[QUEEN]) return evaluateKXK;
+
+    return NULL;
+}
+
+int evaluateKXK(Board *board, int strong) {
+
+    uint64_t ours = board->colours[strong];
+
+    int strongKing = getlsb(ours & board->pieces[KING]);
+    int weakKing   = getlsb(board->colours[!strong] & board->pieces[KING]);
+
+    // Sum up our material, and add a bonus for progress towards mate
+    int eval = KNOWN_WIN
+             + PieceValues[PAWN  ][EG] * popcount(ours & board->pieces[PAWN  ])
+             + PieceValues[KNIGHT][EG] * popcount(ours & board->pieces[KNIGHT])
+             + PieceValues[BISHOP][EG] * popcount(ours & board->pieces[BISHOP])
+             + PieceValues[ROOK  ][EG] * popcount(ours & board->pieces[ROOK  ])
+             + PieceValues[QUEEN ][EG] * popcount(ours & board->pieces[QUEEN ])
+             + PushToEdges[weakKing]
+             + PushClose[distanceBetween(strongKing, weakKing)];
+
+    return MIN(eval, MATE_IN_MAX - 1);
+}
+
+int evaluateKPK(Board *board, int strong) {
+
+    int strongKing = getlsb(board->colours[ strong] & board->pieces[KING]);
+    int weakKing   = getlsb(board->colours[!strong] & board->pieces[KING]);
+    int pawn       = getlsb(board->pieces[PAWN]);
+
+    // The bitbase is exact, so anything other than a win is a dead draw
+    if (!probeKPK(strong, strongKing, pawn, weakKing, board->turn))
+        return 0;
+
+    // Otherwise encourage pushing the Pawn, with our King in support
+    return KNOWN_WIN + PieceValues[PAWN][EG]
+         + 16 * relativeRankOf(strong, pawn)
+         - 4 * distanceBetween(strongKing, pawn);
+}
+
+int evaluateKBNK(Board *board, int strong) {
+
+    int strongKing = getlsb(board->colours[ strong] & board->pieces[KING]);
+    int weakKing   = getlsb(board->colours[!strong] & board->pieces[KING]);
+
+    // Mate can only be forced in a corner of the same colour as our Bishop
+    int corner = (board->pieces[BISHOP] & WHITE_SQUARES) ? weakKing ^ 7 : weakKing;
+
+    return KNOWN_WIN
+         + PieceValues[KNIGHT][EG] + PieceValues[BISHOP][EG]
+         + PushToCorners[corner]
+         + PushClose[distanceBetween(strongKing, weakKing)];
+}
+
+int evaluateKRKP(Board *board, int strong) {
+
+    // Everything is computed as if we were White, and the Pawn were Black
+    int strongKing = relativeSquare(strong, getlsb(board->colours[ strong] & board->pieces[KING]));
+    int weakKing   = relativeSquare(strong, getlsb(board->colours[!strong] & board->pieces[KING]));
+    int rook       = relativeSquare(strong, getlsb(board->pieces[ROOK]));
+    int pawn       = relativeSquare(strong, getlsb(board->pieces[PAWN]));
+
+    int promote = square(0, fileOf(pawn));
+    int tempo   = board->turn == strong;
+
+    // Our King is in front of the Pawn, or the defending King is too far
+    // away to support the Pawn or to harass our Rook, needing one more
+    // square if it is the defender to move. A simple win
+    if (   (fileOf(strongKing) == fileOf(pawn) && strongKing < pawn)
+        || (   distanceBetween(weakKing, pawn) >= 3 + (board->turn != strong)
+            && distanceBetween(weakKing, rook) >= 3))
+        return PieceValues[ROOK][EG] - distanceBetween(strongKing, pawn);
+
+    // An advanced Pawn supported by its King, with our King cut off, is drawish
+    if (    rankOf(weakKing) <= 2
+        &&  distanceBetween(weakKing, pawn) == 1
+        &&  rankOf(strongKing) >= 3
+        &&  distanceBetween(strongKing, pawn) > 2 + tempo)
+        return 80 - 8 * distanceBetween(strongKing, pawn);
+
+    // Otherwise, measure the race between the Kings to the Pawn's path
+    return 200 - 8 * ( distanceBetween(strongKing, pawn - 8)
+                     - distanceBetween(weakKing, pawn - 8)
+                     - distanceBetween(pawn, promote));
+}
+
+int evaluateKRKB(Board *board, int strong) {
+
+    // Generally a draw, but the defending King is safest in the centre
+    int weakKing = getlsb(board->colours[!strong] & board->pieces[KING]);
+    return PushToEdges[weakKing] / 4;
+}
+
+int evaluateKRKN(Board *board, int strong) {
+
+    // Generally a draw, but the Knight should remain close to its King
+    int weakKing   = getlsb(board->colours[!strong] & board->pieces[KING]);
+    int weakKnight = getlsb(board->pieces[KNIGHT]);
+    return (PushToEdges[weakKing] + PushAway[distanceBetween(weakKing, weakKnight)]) / 4;
+}
+
+int evaluateKQKR(Board *board, int strong) {
+
+    int strongKing = getlsb(board->colours[ strong] & board->pieces[KING]);
+    int weakKing   = getlsb(board->colours[!strong] & board->pieces[KING]);
+
+    return PieceValues[QUEEN][EG] - PieceValues[ROOK][EG]
+         + PushToEdges[weakKing]
+         + PushClose[distanceBetween(strongKing, weakKing)];
+}
@@ -0,0 +1,36 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "material.h"
+#include "types.h"
+
+enum {
+    KNOWN_WIN = 10000,
+};
+
+EndgameFunction lookupEndgame(int counts[COLOUR_NB][KING], int strong);
+
+int evaluateKXK(Board *board, int strong);
+int evaluateKPK(Board *board, int strong);
+int evaluateKBNK(Board *board, int strong);
+int evaluateKRKP(Board *board, int strong);
+int evaluateKRKB(Board *board, int strong);
+int evaluateKRKN(Board *board, int strong);
+int evaluateKQKR(Board *board, int strong);
@@ -26,20 +26,18 @@
 #include "board.h"
 #include "bitboards.h"
 #include "castle.h"
+#include "cpu.h"
 #include "evaluate.h"
 #include "masks.h"
+#include "material.h"
 #include "movegen.h"
 #include "psqt.h"
 #include "transposition.h"
 #include "types.h"
 
 #ifdef TUNE
-    const int TRACE = 1;
     const EvalTrace EmptyTrace;
-    EvalTrace T;
-#else
-    const int TRACE = 0;
-    EvalTrace T;
+    __thread EvalTrace T;
 #endif
 
 #define S(mg, eg) (MakeScore((mg), (eg)))
@@ -255,39 +253,59 @@ const int Tempo[COLOUR_NB] = { S(  25,  12), S( -25, -12) };
 
 #undef S
 
-int evaluateBoard(Board* board, PawnKingTable* pktable){
+MULTIVERSION
+int evaluateBoard(Board* board, PawnKingTable* pktable, MaterialTable* mtable, AttackMaps* maps){
 
     EvalInfo ei;
+    MaterialEntry local, *mentry;
     int phase, factor, eval, pkeval;
 
+    // Fetch the material configuration, computing it when we have no table
+    if (mtable != NULL) mentry = getMaterialEntry(mtable, board->matkey);
+    else computeMaterialEntry((mentry = &local), board->matkey);
+
+    // Use a specialized endgame evaluation when one exists. The tuner
+    // needs the regular evaluation terms traced, so it never does this
+    if (mentry->evaluate != NULL && !TRACE) {
+        eval = mentry->evaluate(board, mentry->strong);
+        return board->turn == mentry->strong ? eval : -eval;
+    }
+
     // Setup and perform all evaluations
     initializeEvalInfo(&ei, board, pktable);
     eval   = evaluatePieces(&ei, board);
     pkeval = ei.pkeval[WHITE] - ei.pkeval[BLACK];
     eval  += pkeval + board->psqtmat + Tempo[board->turn];
 
-    // Calcuate the game phase based on remaining material (Fruit Method)
-    phase = 24 - 4 * popcount(board->pieces[QUEEN ])
-               - 2 * popcount(board->pieces[ROOK  ])
-               - 1 * popcount(board->pieces[KNIGHT]
-                             |board->pieces[BISHOP]);
-    phase = (phase * 256 + 12) / 24;
+    // Game phase is computed once per material configuration
+    phase = mentry->phase;
 
     // Scale evaluation based on remaining material
-    factor = evaluateScaleFactor(board);
+    factor = evaluateScaleFactor(board, mentry);
 
     // Compute the interpolated and scaled evaluation
     eval = (ScoreMG(eval) * (256 - phase)
          +  ScoreEG(eval) * phase * factor / SCALE_NORMAL) / 256;
 
+    // Save the attack maps for move ordering and SEE. The maps are tagged
+    // with the position's hash, so a stale set is never mistaken as valid
+    if (maps != NULL) {
+        maps->hash                = board->hash;
+        maps->attacked[WHITE]     = ei.attacked[WHITE];
+        maps->attacked[BLACK]     = ei.attacked[BLACK];
+        maps->pawnAttacks[WHITE]  = ei.pawnAttacks[WHITE];
+        maps->pawnAttacks[BLACK]  = ei.pawnAttacks[BLACK];
+    }
+
     // Store a new Pawn King Entry if we did not have one
-    if (ei.pkentry == NULL && pktable != NULL)
+    if (!ei.pkhit && pktable != NULL)
         storePawnKingEntry(pktable, board->pkhash, ei.passedPawns, pkeval);
 
     // Return the evaluation relative to the side to move
     return board->turn == WHITE ? eval : -eval;
 }
 
+MULTIVERSION
 int evaluatePieces(EvalInfo *ei, Board *board) {
 
     int eval = 0;
@@ -319,6 +337,7 @@ int evaluatePieces(EvalInfo *ei, Board *board) {
     return eval;
 }
 
+MULTIVERSION
 int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
@@ -337,7 +356,7 @@ int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
     ei->kingAttacksCount[US] += popcount(attacks);
 
     // Pawn hash holds the rest of the pawn evaluation
-    if (ei->pkentry != NULL) return eval;
+    if (ei->pkhit) return eval;
 
     pawns = board->pieces[PAWN];
     myPawns = tempPawns = pawns & board->colours[US];
@@ -348,8 +367,8 @@ int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
 
         // Pop off the next pawn
         sq = poplsb(&tempPawns);
-        if (TRACE) T.PawnValue[US]++;
-        if (TRACE) T.PawnPSQT32[relativeSquare32(sq, US)][US]++;
+        TRACE_INCR(PawnValue[US]);
+        TRACE_INCR(PawnPSQT32[relativeSquare32(sq, US)][US]);
 
         uint64_t stoppers    = enemyPawns & passedPawnMasks(US, sq);
         uint64_t threats     = enemyPawns & pawnAttacks(US, sq);
@@ -366,19 +385,19 @@ int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
         else if (!leftovers && popcount(pushSupport) >= popcount(pushThreats)) {
             flag = popcount(support) >= popcount(threats);
             pkeval += PawnCandidatePasser[flag][relativeRankOf(US, sq)];
-            if (TRACE) T.PawnCandidatePasser[flag][relativeRankOf(US, sq)][US]++;
+            TRACE_INCR(PawnCandidatePasser[flag][relativeRankOf(US, sq)][US]);
         }
 
         // Apply a penalty if the pawn is isolated
         if (!(adjacentFilesMasks(fileOf(sq)) & myPawns)) {
             pkeval += PawnIsolated;
-            if (TRACE) T.PawnIsolated[US]++;
+            TRACE_INCR(PawnIsolated[US]);
         }
 
         // Apply a penalty if the pawn is stacked
         if (Files[fileOf(sq)] & tempPawns) {
             pkeval += PawnStacked;
-            if (TRACE) T.PawnStacked[US]++;
+            TRACE_INCR(PawnStacked[US]);
         }
 
         // Apply a penalty if the pawn is backward
@@ -386,13 +405,13 @@ int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
             &&  (testBit(ei->pawnAttacks[THEM], sq + Forward))) {
             flag = !(Files[fileOf(sq)] & enemyPawns);
             pkeval += PawnBackwards[flag];
-            if (TRACE) T.PawnBackwards[flag][US]++;
+            TRACE_INCR(PawnBackwards[flag][US]);
         }
 
         // Apply a bonus if the pawn is connected and not backward
         else if (pawnConnectedMasks(US, sq) & myPawns) {
             pkeval += PawnConnected32[relativeSquare32(sq, US)];
-            if (TRACE) T.PawnConnected32[relativeSquare32(sq, US)][US]++;
+            TRACE_INCR(PawnConnected32[relativeSquare32(sq, US)][US]);
         }
     }
 
@@ -401,6 +420,7 @@ int evaluatePawns(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
+MULTIVERSION
 int evaluateKnights(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
@@ -418,8 +438,8 @@ int evaluateKnights(EvalInfo *ei, Board *board, int colour) {
 
         // Pop off the next knight
         sq = poplsb(&tempKnights);
-        if (TRACE) T.KnightValue[US]++;
-        if (TRACE) T.KnightPSQT32[relativeSquare32(sq, US)][US]++;
+        TRACE_INCR(KnightValue[US]);
+        TRACE_INCR(KnightPSQT32[relativeSquare32(sq, US)][US]);
 
         // Compute possible attacks and store off information for king safety
         attacks = knightAttacks(sq);
@@ -433,19 +453,19 @@ int evaluateKnights(EvalInfo *ei, Board *board, int colour) {
             && !(outpostSquareMasks(US, sq) & enemyPawns)) {
             defended = testBit(ei->pawnAttacks[US], sq);
             eval += KnightOutpost[defended];
-            if (TRACE) T.KnightOutpost[defended][US]++;
+            TRACE_INCR(KnightOutpost[defended][US]);
         }
 
         // Apply a bonus if the knight is behind a pawn
         if (testBit(pawnAdvance(board->pieces[PAWN], 0ull, THEM), sq)) {
             eval += KnightBehindPawn;
-            if (TRACE) T.KnightBehindPawn[US]++;
+            TRACE_INCR(KnightBehindPawn[US]);
         }
 
         // Apply a bonus (or penalty) based on the mobility of the knight
         count = popcount(ei->mobilityAreas[US] & attacks);
         eval += KnightMobility[count];
-        if (TRACE) T.KnightMobility[count][US]++;
+        TRACE_INCR(KnightMobility[count][US]);
 
         // Update for King Safety calculation
         attacks = attacks & ei->kingAreas[THEM];
@@ -459,6 +479,7 @@ int evaluateKnights(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
+MULTIVERSION
 int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
@@ -475,7 +496,7 @@ int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
     // Apply a bonus for having a pair of bishops
     if ((tempBishops & WHITE_SQUARES) && (tempBishops & BLACK_SQUARES)) {
         eval += BishopPair;
-        if (TRACE) T.BishopPair[US]++;
+        TRACE_INCR(BishopPair[US]);
     }
 
     // Evaluate each bishop
@@ -483,8 +504,8 @@ int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
 
         // Pop off the next Bishop
         sq = poplsb(&tempBishops);
-        if (TRACE) T.BishopValue[US]++;
-        if (TRACE) T.BishopPSQT32[relativeSquare32(sq, US)][US]++;
+        TRACE_INCR(BishopValue[US]);
+        TRACE_INCR(BishopPSQT32[relativeSquare32(sq, US)][US]);
 
         // Compute possible attacks and store off information for king safety
         attacks = bishopAttacks(sq, ei->occupiedMinusBishops[US]);
@@ -496,7 +517,7 @@ int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
         // of our own colour, which reside on the same shade of square as the bishop
         count = popcount(ei->rammedPawns[US] & (testBit(WHITE_SQUARES, sq) ? WHITE_SQUARES : BLACK_SQUARES));
         eval += count * BishopRammedPawns;
-        if (TRACE) T.BishopRammedPawns[US] += count;
+        TRACE_ADD(BishopRammedPawns[US], count);
 
         // Apply a bonus if the bishop is on an outpost square, and cannot be attacked
         // by an enemy pawn. Increase the bonus if one of our pawns supports the bishop.
@@ -504,19 +525,19 @@ int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
             && !(outpostSquareMasks(US, sq) & enemyPawns)) {
             defended = testBit(ei->pawnAttacks[US], sq);
             eval += BishopOutpost[defended];
-            if (TRACE) T.BishopOutpost[defended][US]++;
+            TRACE_INCR(BishopOutpost[defended][US]);
         }
 
         // Apply a bonus if the bishop is behind a pawn
         if (testBit(pawnAdvance((myPawns | enemyPawns), 0ull, THEM), sq)) {
             eval += BishopBehindPawn;
-            if (TRACE) T.BishopBehindPawn[US]++;
+            TRACE_INCR(BishopBehindPawn[US]);
         }
 
         // Apply a bonus (or penalty) based on the mobility of the bishop
         count = popcount(ei->mobilityAreas[US] & attacks);
         eval += BishopMobility[count];
-        if (TRACE) T.BishopMobility[count][US]++;
+        TRACE_INCR(BishopMobility[count][US]);
 
         // Update for King Safety calculation
         attacks = attacks & ei->kingAreas[THEM];
@@ -530,6 +551,7 @@ int evaluateBishops(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
+MULTIVERSION
 int evaluateRooks(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
@@ -548,8 +570,8 @@ int evaluateRooks(EvalInfo *ei, Board *board, int colour) {
 
         // Pop off the next rook
         sq = poplsb(&tempRooks);
-        if (TRACE) T.RookValue[US]++;
-        if (TRACE) T.RookPSQT32[relativeSquare32(sq, US)][US]++;
+        TRACE_INCR(RookValue[US]);
+        TRACE_INCR(RookPSQT32[relativeSquare32(sq, US)][US]);
 
         // Compute possible attacks and store off information for king safety
         attacks = rookAttacks(sq, ei->occupiedMinusRooks[US]);
@@ -562,7 +584,7 @@ int evaluateRooks(EvalInfo *ei, Board *board, int colour) {
         if (!(myPawns & Files[fileOf(sq)])) {
             open = !(enemyPawns & Files[fileOf(sq)]);
             eval += RookFile[open];
-            if (TRACE) T.RookFile[open][US]++;
+            TRACE_INCR(RookFile[open][US]);
         }
 
         // Rook gains a bonus for being located on seventh rank relative to its
@@ -570,13 +592,13 @@ int evaluateRooks(EvalInfo *ei, Board *board, int colour) {
         if (   relativeRankOf(US, sq) == 6
             && relativeRankOf(US, ei->kingSquare[THEM]) >= 6) {
             eval += RookOnSeventh;
-            if (TRACE) T.RookOnSeventh[US]++;
+            TRACE_INCR(RookOnSeventh[US]);
         }
 
         // Apply a bonus (or penalty) based on the mobility of the rook
         count = popcount(ei->mobilityAreas[US] & attacks);
         eval += RookMobility[count];
-        if (TRACE) T.RookMobility[count][US]++;
+        TRACE_INCR(RookMobility[count][US]);
 
         // Update for King Safety calculation
         attacks = attacks & ei->kingAreas[THEM];
@@ -590,6 +612,7 @@ int evaluateRooks(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
+MULTIVERSION
 int evaluateQueens(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
@@ -606,8 +629,8 @@ int evaluateQueens(EvalInfo *ei, Board *board, int colour) {
 
         // Pop off the next queen
         sq = poplsb(&tempQueens);
-        if (TRACE) T.QueenValue[US]++;
-        if (TRACE) T.QueenPSQT32[relativeSquare32(sq, US)][US]++;
+        TRACE_INCR(QueenValue[US]);
+        TRACE_INCR(QueenPSQT32[relativeSquare32(sq, US)][US]);
 
         // Compute possible attacks and store off information for king safety
         attacks = rookAttacks(sq, ei->occupiedMinusRooks[US])
@@ -619,7 +642,7 @@ int evaluateQueens(EvalInfo *ei, Board *board, int colour) {
         // Apply a bonus (or penalty) based on the mobility of the queen
         count = popcount(ei->mobilityAreas[US] & attacks);
         eval += QueenMobility[count];
-        if (TRACE) T.QueenMobility[count][US]++;
+        TRACE_INCR(QueenMobility[count][US]);
 
         // Update for King Safety calculation
         attacks = attacks & ei->kingAreas[THEM];
@@ -633,6 +656,7 @@ int evaluateQueens(EvalInfo *ei, Board *board, int colour) {
     return eval;
 }
 
+MULTIVERSION
 int evaluateKings(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
@@ -651,13 +675,13 @@ int evaluateKings(EvalInfo *ei, Board *board, int colour) {
     int kingFile = fileOf(kingSq);
     int kingRank = rankOf(kingSq);
 
-    if (TRACE) T.KingValue[US]++;
-    if (TRACE) T.KingPSQT32[relativeSquare32(kingSq, US)][US]++;
+    TRACE_INCR(KingValue[US]);
+    TRACE_INCR(KingPSQT32[relativeSquare32(kingSq, US)][US]);
 
     // Bonus for our pawns and minors sitting within our king area
     count = popcount(myDefenders & ei->kingAreas[US]);
     eval += KingDefenders[count];
-    if (TRACE) T.KingDefenders[count][US]++;
+    TRACE_INCR(KingDefenders[count][US]);
 
     // Perform King Safety when we have two attackers, or
     // one attacker with a potential for a Queen attacker
@@ -709,7 +733,7 @@ int evaluateKings(EvalInfo *ei, Board *board, int colour) {
     }
 
     // King Shelter & King Storm are stored in the Pawn King Table
-    if (ei->pkentry != NULL) return eval;
+    if (ei->pkhit) return eval;
 
     // Evaluate King Shelter & King Storm threat by looking at the file of our King,
     // as well as the adjacent files. When looking at pawn distances, we will use a
@@ -727,18 +751,19 @@ int evaluateKings(EvalInfo *ei, Board *board, int colour) {
         // Evaluate King Shelter using pawn distance. Use seperate evaluation
         // depending on the file, and if we are looking at the King's file
         ei->pkeval[US] += KingShelter[file == kingFile][file][ourDist];
-        if (TRACE) T.KingShelter[file == kingFile][file][ourDist][US]++;
+        TRACE_INCR(KingShelter[file == kingFile][file][ourDist][US]);
 
         // Evaluate King Storm using enemy pawn distance. Use a seperate evaluation
         // depending on the file, and if the opponent's pawn is blocked by our own
         int blocked = (ourDist != 7 && (ourDist == theirDist - 1));
         ei->pkeval[US] += KingStorm[blocked][mirrorFile(file)][theirDist];
-        if (TRACE) T.KingStorm[blocked][mirrorFile(file)][theirDist][US]++;
+        TRACE_INCR(KingStorm[blocked][mirrorFile(file)][theirDist][US]);
     }
 
     return eval;
 }
 
+MULTIVERSION
 int evaluatePassedPawns(EvalInfo* ei, Board* board, int colour){
 
     const int US = colour, THEM = !colour;
@@ -761,28 +786,29 @@ int evaluatePassedPawns(EvalInfo* ei, Board* board, int colour){
         canAdvance = !(bitboard & occupied);
         safeAdvance = !(bitboard & ei->attacked[THEM]);
         eval += PassedPawn[canAdvance][safeAdvance][rank];
-        if (TRACE) T.PassedPawn[canAdvance][safeAdvance][rank][US]++;
+        TRACE_INCR(PassedPawn[canAdvance][safeAdvance][rank][US]);
 
         // Evaluate based on distance from our king
         dist = distanceBetween(sq, ei->kingSquare[US]);
         eval += dist * PassedFriendlyDistance[rank];
-        if (TRACE) T.PassedFriendlyDistance[rank][US] += dist;
+        TRACE_ADD(PassedFriendlyDistance[rank][US], dist);
 
         // Evaluate based on distance from their king
         dist = distanceBetween(sq, ei->kingSquare[THEM]);
         eval += dist * PassedEnemyDistance[rank];
-        if (TRACE) T.PassedEnemyDistance[rank][US] += dist;
+        TRACE_ADD(PassedEnemyDistance[rank][US], dist);
 
         // Apply a bonus when the path to promoting is uncontested
         bitboard = forwardRanksMasks(US, rankOf(sq)) & Files[fileOf(sq)];
         flag = !(bitboard & ei->attacked[THEM]);
         eval += flag * PassedSafePromotionPath;
-        if (TRACE) T.PassedSafePromotionPath[US] += flag;
+        TRACE_ADD(PassedSafePromotionPath[US], flag);
     }
 
     return eval;
 }
 
+MULTIVERSION
 int evaluateThreats(EvalInfo *ei, Board *board, int colour) {
 
     const int US = colour, THEM = !colour;
@@ -824,78 +850,61 @@ int evaluateThreats(EvalInfo *ei, Board *board, int colour) {
     // Penalty for each of our poorly supported pawns
     count = popcount(pawns & ~attacksByPawns & poorlyDefended);
     eval += count * ThreatWeakPawn;
-    if (TRACE) T.ThreatWeakPawn[US] += count;
+    TRACE_ADD(ThreatWeakPawn[US], count);
 
     // Penalty for pawn threats against our minors
     count = popcount((knights | bishops) & attacksByPawns);
     eval += count * ThreatMinorAttackedByPawn;
-    if (TRACE) T.ThreatMinorAttackedByPawn[US] += count;
+    TRACE_ADD(ThreatMinorAttackedByPawn[US], count);
 
     // Penalty for any minor threat against minor pieces
     count = popcount((knights | bishops) & attacksByMinors);
     eval += count * ThreatMinorAttackedByMinor;
-    if (TRACE) T.ThreatMinorAttackedByMinor[US] += count;
+    TRACE_ADD(ThreatMinorAttackedByMinor[US], count);
 
     // Penalty for all major threats against poorly supported minors
     count = popcount((knights | bishops) & poorlyDefended & attacksByMajors);
     eval += count * ThreatMinorAttackedByMajor;
-    if (TRACE) T.ThreatMinorAttackedByMajor[US] += count;
+    TRACE_ADD(ThreatMinorAttackedByMajor[US], count);
 
     // Penalty for pawn and minor threats against our rooks
     count = popcount(rooks & (attacksByPawns | attacksByMinors));
     eval += count * ThreatRookAttackedByLesser;
-    if (TRACE) T.ThreatRookAttackedByLesser[US] += count;
+    TRACE_ADD(ThreatRookAttackedByLesser[US], count);
 
     // Penalty for any threat against our queens
     count = popcount(queens & ei->attacked[THEM]);
     eval += count * ThreatQueenAttackedByOne;
-    if (TRACE) T.ThreatQueenAttackedByOne[US] += count;
+    TRACE_ADD(ThreatQueenAttackedByOne[US], count);
 
     // Penalty for any overloaded minors or majors
     count = popcount(overloaded);
     eval += count * ThreatOverloadedPieces;
-    if (TRACE) T.ThreatOverloadedPieces[US] += count;
+    TRACE_ADD(ThreatOverloadedPieces[US], count);
 
     // Bonus for giving threats by safe pawn pushes
     count = popcount(pushThreat);
     eval += count * ThreatByPawnPush;
-    if (TRACE) T.ThreatByPawnPush[colour] += count;
+    TRACE_ADD(ThreatByPawnPush[colour], count);
 
     return eval;
 }
 
-int evaluateScaleFactor(Board *board) {
-
-    uint64_t white   = board->colours[WHITE];
-    uint64_t black   = board->colours[BLACK];
-    uint64_t knights = board->pieces[KNIGHT];
-    uint64_t bishops = board->pieces[BISHOP];
-    uint64_t rooks   = board->pieces[ROOK  ];
-    uint64_t queens  = board->pieces[QUEEN ];
-
-    if (    onlyOne(white & bishops)
-        &&  onlyOne(black & bishops)
-        &&  onlyOne(bishops & WHITE_SQUARES)) {
-
-        if (!(knights | rooks | queens))
-            return SCALE_OCB_BISHOPS_ONLY;
+int evaluateScaleFactor(Board *board, MaterialEntry *mentry) {
 
-        if (   !(rooks | queens)
-            &&  onlyOne(white & knights)
-            &&  onlyOne(black & knights))
-            return SCALE_OCB_ONE_KNIGHT;
-
-        if (   !(knights | queens)
-            && onlyOne(white & rooks)
-            && onlyOne(black & rooks))
-            return SCALE_OCB_ONE_ROOK;
-    }
+    // The material entry knows when each side has a single bishop, along
+    // with the remaining pieces, but only the board knows the square colours
+    if (    mentry->ocbscale != SCALE_NORMAL
+        &&  onlyOne(board->pieces[BISHOP] & WHITE_SQUARES))
+        return mentry->ocbscale;
 
     return SCALE_NORMAL;
 }
 
 void initializeEvalInfo(EvalInfo* ei, Board* board, PawnKingTable* pktable){
 
+    PawnKingEntry pkentry;
+
     uint64_t white   = board->colours[WHITE];
     uint64_t black   = board->colours[BLACK];
     uint64_t pawns   = board->pieces[PAWN];
@@ -938,8 +947,8 @@ void initializeEvalInfo(EvalInfo* ei, Board* board, PawnKingTable* pktable){
     ei->kingAttackersCount[WHITE]  = ei->kingAttackersCount[BLACK]  = 0;
     ei->kingAttackersWeight[WHITE] = ei->kingAttackersWeight[BLACK] = 0;
 
-    ei->pkentry       =     pktable == NULL ? NULL : getPawnKingEntry(pktable, board->pkhash);
-    ei->passedPawns   = ei->pkentry == NULL ? 0ull : ei->pkentry->passed;
-    ei->pkeval[WHITE] = ei->pkentry == NULL ? 0    : ei->pkentry->eval;
-    ei->pkeval[BLACK] = ei->pkentry == NULL ? 0    : 0;
+    ei->pkhit         = pktable == NULL ? 0 : getPawnKingEntry(pktable, board->pkhash, &pkentry);
+    ei->passedPawns   = ei->pkhit ? pkentry.passed : 0ull;
+    ei->pkeval[WHITE] = ei->pkhit ? pkentry.eval   : 0;
+    ei->pkeval[BLACK] = 0;
 }
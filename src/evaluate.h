@@ -75,6 +75,22 @@ struct EvalTrace {
     int ThreatByPawnPush[COLOUR_NB];
 };
 
+// Tracing of evaluation terms is only compiled for the tuner. Each thread owns
+// its own trace, so that positions may be traced in parallel. In all other
+// builds the tracing macros expand to nothing, leaving no writes or branches
+
+#if defined(TUNE)
+    #define TRACE (1)
+    #define TRACE_INCR(term)       (T.term++)
+    #define TRACE_ADD(term, value) (T.term += (value))
+    extern const EvalTrace EmptyTrace;
+    extern __thread EvalTrace T;
+#else
+    #define TRACE (0)
+    #define TRACE_INCR(term)
+    #define TRACE_ADD(term, value)
+#endif
+
 struct EvalInfo {
     uint64_t pawnAttacks[COLOUR_NB];
     uint64_t rammedPawns[COLOUR_NB];
@@ -92,10 +108,16 @@ struct EvalInfo {
     int kingAttackersCount[COLOUR_NB];
     int kingAttackersWeight[COLOUR_NB];
     int pkeval[COLOUR_NB];
-    PawnKingEntry* pkentry;
+    int pkhit;
+};
+
+struct AttackMaps {
+    uint64_t hash;
+    uint64_t attacked[COLOUR_NB];
+    uint64_t pawnAttacks[COLOUR_NB];
 };
 
-int evaluateBoard(Board *board, PawnKingTable *pktable);
+int evaluateBoard(Board *board, PawnKingTable *pktable, MaterialTable *mtable, AttackMaps *maps);
 int evaluatePieces(EvalInfo *ei, Board *board);
 int evaluatePawns(EvalInfo *ei, Board *board, int colour);
 int evaluateKnights(EvalInfo *ei, Board *board, int colour);
@@ -105,7 +127,7 @@ int evaluateQueens(EvalInfo *ei, Board *board, int colour);
 int evaluateKings(EvalInfo *ei, Board *board, int colour);
 int evaluatePassedPawns(EvalInfo *ei, Board *board, int colour);
 int evaluateThreats(EvalInfo *ei, Board *board, int colour);
-int evaluateScaleFactor(Board *board);
+int evaluateScaleFactor(Board *board, MaterialEntry *mentry);
 void initializeEvalInfo(EvalInfo *ei, Board *board, PawnKingTable *pktable);
 
 #define MakeScore(mg, eg) ((int)((unsigned int)(eg) << 16) + (mg))
@@ -74,11 +74,6 @@
  */
 /* #define TB_NO_STDBOOL */
 
-/*
- * Define TB_NO_THREADS if your program is not multi-threaded.
- */
-/* #define TB_NO_THREADS */
-
 /*
  * Define TB_NO_HELPER_API if you do not need the helper API.
  */
@@ -66,10 +66,6 @@
 #define TB_WPAWN TB_PAWN
 #define TB_BPAWN (TB_PAWN | 8)
 
-#ifndef TB_NO_THREADS
-static LOCK_T TB_MUTEX;
-#endif
-
 #ifdef TB_CUSTOM_BSWAP32
 #define internal_bswap32(x) TB_CUSTOM_BSWAP32(x)
 #else
@@ -90,6 +86,8 @@ static char **paths = NULL;
 static int TBnum_piece, TBnum_pawn;
 static struct TBEntry_piece TB_piece[TBMAX_PIECE];
 static struct TBEntry_pawn TB_pawn[TBMAX_PAWN];
+static char TB_piece_name[TBMAX_PIECE][16];
+static char TB_pawn_name[TBMAX_PAWN][16];
 
 static struct TBHashEntry TB_hash[1 << TBHASHBITS][HSHMAX];
 
@@ -275,17 +273,19 @@ static void init_tb(char *str)
       fprintf(stderr,"TBMAX_PIECE limit too low!\n");
       exit(1);
     }
+    strcpy(TB_piece_name[TBnum_piece], str);
     entry = (struct TBEntry *)&TB_piece[TBnum_piece++];
   } else {
     if (TBnum_pawn == TBMAX_PAWN) {
       fprintf(stderr,"TBMAX_PAWN limit too low!\n");
       exit(1);
     }
+    strcpy(TB_pawn_name[TBnum_pawn], str);
     entry = (struct TBEntry *)&TB_pawn[TBnum_pawn++];
   }
 
   entry->key = key;
-  entry->ready = 0;
+  entry->ready = TB_UNLOADED;
   entry->num = 0;
   for (i = 0; i < 16; i++)
     entry->num += pcs[i];
@@ -366,8 +366,6 @@ void init_tablebases(const char *path)
     while (path_string[j]) j++;
   }
 
-  LOCK_INIT(TB_MUTEX);
-
   TBnum_piece = TBnum_pawn = 0;
   TB_LARGEST = 0;
 
@@ -11,7 +11,7 @@
 #endif
 
 #ifndef _WIN32
-#include <pthread.h>
+#include <sched.h>
 #define SEP_CHAR ':'
 #define FD int
 #define FD_ERR -1
@@ -22,34 +22,27 @@
 #define FD_ERR INVALID_HANDLE_VALUE
 #endif
 
-#ifndef TB_NO_THREADS
-#if defined(__cplusplus) && (__cplusplus >= 201103L)
-
-#include <mutex>
-#define LOCK_T std::mutex
-#define LOCK_INIT(x)
-#define LOCK(x) x.lock()
-#define UNLOCK(x) x.unlock()
+/*
+ * The ready field of a WDL table moves through these states once per
+ * tb_init().  The thread which claims TB_LOADING maps the table, then
+ * publishes TB_READY or TB_FAILED with release ordering.  Probing a ready
+ * table needs only an acquire load of the state, and never takes a lock.
+ */
+#define TB_UNLOADED 0
+#define TB_LOADING  1
+#define TB_READY    2
+#define TB_FAILED   3
+
+#define TB_LOAD_STATE(x)     __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define TB_STORE_STATE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define TB_CLAIM_STATE(x, e, v) \
+    __atomic_compare_exchange_n(&(x), &(e), (v), 0, \
+        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
 
-#else
 #ifndef _WIN32
-#define LOCK_T pthread_mutex_t
-#define LOCK_INIT(x) pthread_mutex_init(&(x), NULL)
-#define LOCK(x) pthread_mutex_lock(&(x))
-#define UNLOCK(x) pthread_mutex_unlock(&(x))
+#define TB_YIELD() sched_yield()
 #else
-#define LOCK_T HANDLE
-#define LOCK_INIT(x) do { x = CreateMutex(NULL, FALSE, NULL); } while (0)
-#define LOCK(x) WaitForSingleObject(x, INFINITE)
-#define UNLOCK(x) ReleaseMutex(x)
-#endif
-
-#endif
-#else /* TB_NO_THREADS */
-#define LOCK_T          int
-#define LOCK_INIT(x)    /* NOP */
-#define LOCK(x)         /* NOP */
-#define UNLOCK(x)       /* NOP */
+#define TB_YIELD() SwitchToThread()
 #endif
 
 #define WDLSUFFIX ".rtbw"
@@ -228,6 +228,31 @@ static uint64_t get_pieces(const struct pos *pos, uint8_t code)
     }
 }
 
+// Map and initialize a WDL table on first use. Returns 0 on failure.
+// Threads race to claim the table, and the losers wait for the winner
+// to publish it, so tables never share a lock, and ready ones need none.
+static int load_table_wdl(struct TBEntry *ptr, const char *str)
+{
+    ubyte state = TB_LOAD_STATE(ptr->ready);
+    if (state == TB_UNLOADED)
+    {
+        ubyte expected = TB_UNLOADED;
+        if (TB_CLAIM_STATE(ptr->ready, expected, TB_LOADING))
+        {
+            state = init_table_wdl(ptr, (char *)str) ? TB_READY : TB_FAILED;
+            TB_STORE_STATE(ptr->ready, state);
+        }
+        else
+            state = expected;
+    }
+    while (state == TB_LOADING)
+    {
+        TB_YIELD();
+        state = TB_LOAD_STATE(ptr->ready);
+    }
+    return state == TB_READY;
+}
+
 static int probe_wdl_table(const struct pos *pos, int *success)
 {
     struct TBEntry *ptr;
@@ -258,31 +283,15 @@ static int probe_wdl_table(const struct pos *pos, int *success)
     }
 
     ptr = ptr2[i].ptr;
-    if (!ptr->ready)
+    if (TB_LOAD_STATE(ptr->ready) != TB_READY)
     {
-        LOCK(TB_MUTEX);
-        if (!ptr->ready)
+        char str[16];
+        prt_str(pos, str, ptr->key != key);
+        if (!load_table_wdl(ptr, str))
         {
-            char str[16];
-            prt_str(pos, str, ptr->key != key);
-            if (!init_table_wdl(ptr, str))
-            {
-                ptr2[i].key = 0ULL;
-                *success = 0;
-                UNLOCK(TB_MUTEX);
-                return 0;
-            }
-            // Memory barrier to ensure ptr->ready = 1 is not reordered.
-#if !defined(__cplusplus) || !defined(TB_USE_ATOMIC)
-#ifdef __GNUC__
-            __asm__ __volatile__ ("" ::: "memory");
-#elif defined(_MSC_VER)
-            MemoryBarrier();
-#endif
-#endif
-            ptr->ready = 1;
+            *success = 0;
+            return 0;
         }
-        UNLOCK(TB_MUTEX);
     }
 
     int bside, mirror, cmirror;
@@ -1391,6 +1400,36 @@ bool tb_init_impl(const char *path)
     return true;
 }
 
+// Map every WDL table with the given number of pieces now, rather than on
+// its first probe, and ask the OS to start reading it into the page cache.
+static void preload_table_wdl(struct TBEntry *entry, const char *str,
+    unsigned *count, uint64_t *bytes)
+{
+    if (!load_table_wdl(entry, str))
+        return;
+#ifndef _WIN32
+    madvise(entry->data, entry->mapping, MADV_WILLNEED);
+    *bytes += entry->mapping;
+#endif
+    (*count)++;
+}
+
+unsigned tb_preload_impl(unsigned pieces, uint64_t *bytes)
+{
+    unsigned count = 0;
+    int i;
+    *bytes = 0;
+    for (i = 0; i < TBnum_piece; i++)
+        if (TB_piece[i].num == pieces)
+            preload_table_wdl((struct TBEntry *)&TB_piece[i],
+                TB_piece_name[i], &count, bytes);
+    for (i = 0; i < TBnum_pawn; i++)
+        if (TB_pawn[i].num == pieces)
+            preload_table_wdl((struct TBEntry *)&TB_pawn[i],
+                TB_pawn_name[i], &count, bytes);
+    return count;
+}
+
 unsigned tb_probe_wdl_impl(
     uint64_t white,
     uint64_t black,
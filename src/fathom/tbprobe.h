@@ -58,6 +58,9 @@ typedef uint8_t bool;
  * Internal definitions.  Do not call these functions directly.
  */
 extern bool tb_init_impl(const char *_path);
+extern unsigned tb_preload_impl(
+    unsigned _pieces,
+    uint64_t *_bytes);
 extern unsigned tb_probe_wdl_impl(
     uint64_t _white,
     uint64_t _black,
@@ -177,6 +180,26 @@ static inline bool tb_init(const char *_path)
     return tb_init_impl(_path);
 }
 
+/*
+ * Map the WDL tables now instead of on their first probe, and advise the OS
+ * to read them into the page cache (MADV_WILLNEED).  This may be called from
+ * a background thread while the tables are being probed.
+ *
+ * PARAMETERS:
+ * - pieces:
+ *   Only tables with exactly this many pieces are mapped.
+ * - bytes:
+ *   Receives the total size of the mapped tables.
+ *
+ * RETURN:
+ * - The number of tables which were mapped.  The size of those tables in
+ *   bytes is written to _bytes (always zero on Windows).
+ */
+static inline unsigned tb_preload(unsigned _pieces, uint64_t *_bytes)
+{
+    return tb_preload_impl(_pieces, _bytes);
+}
+
 /*
  * Probe the Win-Draw-Loss (WDL) table.
  *
@@ -199,7 +222,7 @@ static inline bool tb_init(const char *_path)
  *
  * NOTES:
  * - Engines should use this function during search.
- * - This function is thread safe assuming TB_NO_THREADS is disabled.
+ * - This function is thread safe.
  */
 static inline unsigned tb_probe_wdl(
     uint64_t _white,
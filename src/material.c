@@ -0,0 +1,108 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "endgame.h"
+#include "evaluate.h"
+#include "material.h"
+#include "types.h"
+
+// Each colour and piece type below the King is given a four bit counter
+// within the material key. Applying a move simply adds and subtracts the
+// key of each piece gained or lost, and the counts can be read back out
+const uint64_t MaterialKeys[32] = {
+    [WHITE_PAWN  ] = 1ull <<  0, [BLACK_PAWN  ] = 1ull <<  4,
+    [WHITE_KNIGHT] = 1ull <<  8, [BLACK_KNIGHT] = 1ull << 12,
+    [WHITE_BISHOP] = 1ull << 16, [BLACK_BISHOP] = 1ull << 20,
+    [WHITE_ROOK  ] = 1ull << 24, [BLACK_ROOK  ] = 1ull << 28,
+    [WHITE_QUEEN ] = 1ull << 32, [BLACK_QUEEN ] = 1ull << 36,
+};
+
+int materialCount(uint64_t matkey, int colour, int piece) {
+    assert(0 <= colour && colour < COLOUR_NB);
+    assert(0 <= piece && piece < KING);
+    return (matkey >> (8 * piece + 4 * colour)) & 0xF;
+}
+
+MaterialEntry* getMaterialEntry(MaterialTable *mtable, uint64_t matkey) {
+
+    // Fibonacci hashing spreads the densely packed counters over the table
+    MaterialEntry *mentry = &mtable->entries[(matkey * 0x9E3779B97F4A7C15ull) >> 52];
+
+    // A zeroed entry would otherwise match KvK, which we always recompute
+    if (mentry->matkey != matkey || matkey == 0ull)
+        computeMaterialEntry(mentry, matkey);
+
+    return mentry;
+}
+
+void computeMaterialEntry(MaterialEntry *mentry, uint64_t matkey) {
+
+    int counts[COLOUR_NB][KING], phase;
+
+    for (int colour = WHITE; colour <= BLACK; colour++)
+        for (int piece = PAWN; piece < KING; piece++)
+            counts[colour][piece] = materialCount(matkey, colour, piece);
+
+    mentry->matkey = matkey;
+
+    // Calcuate the game phase based on remaining material (Fruit Method)
+    phase = 24 - 4 * (counts[WHITE][QUEEN ] + counts[BLACK][QUEEN ])
+               - 2 * (counts[WHITE][ROOK  ] + counts[BLACK][ROOK  ])
+               - 1 * (counts[WHITE][KNIGHT] + counts[BLACK][KNIGHT])
+               - 1 * (counts[WHITE][BISHOP] + counts[BLACK][BISHOP]);
+    mentry->phase = (phase * 256 + 12) / 24;
+
+    // Opposite coloured bishop endings are drawish, depending on the remaining
+    // pieces. We can only tell from the material that one bishop remains for
+    // each side. The square colours of the bishops are checked during evaluation
+    mentry->ocbscale = SCALE_NORMAL;
+
+    if (    counts[WHITE][BISHOP] == 1
+        &&  counts[BLACK][BISHOP] == 1) {
+
+        int knights = counts[WHITE][KNIGHT] + counts[BLACK][KNIGHT];
+        int rooks   = counts[WHITE][ROOK  ] + counts[BLACK][ROOK  ];
+        int queens  = counts[WHITE][QUEEN ] + counts[BLACK][QUEEN ];
+
+        if (!knights && !rooks && !queens)
+            mentry->ocbscale = SCALE_OCB_BISHOPS_ONLY;
+
+        else if (   !rooks && !queens
+                 &&  counts[WHITE][KNIGHT] == 1
+                 &&  counts[BLACK][KNIGHT] == 1)
+            mentry->ocbscale = SCALE_OCB_ONE_KNIGHT;
+
+        else if (   !knights && !queens
+                 &&  counts[WHITE][ROOK] == 1
+                 &&  counts[BLACK][ROOK] == 1)
+            mentry->ocbscale = SCALE_OCB_ONE_ROOK;
+    }
+
+    // Look for a specialized evaluation function for either colour
+    mentry->strong   = WHITE;
+    mentry->evaluate = lookupEndgame(counts, WHITE);
+
+    if (mentry->evaluate == NULL) {
+        mentry->strong   = BLACK;
+        mentry->evaluate = lookupEndgame(counts, BLACK);
+    }
+}
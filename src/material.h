@@ -0,0 +1,48 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+enum {
+    MATERIAL_TABLE_SIZE = 0x1000,
+};
+
+typedef int (*EndgameFunction)(Board *board, int strong);
+
+struct MaterialEntry {
+    uint64_t matkey;
+    EndgameFunction evaluate;
+    int16_t phase;
+    uint8_t ocbscale;
+    uint8_t strong;
+};
+
+struct MaterialTable {
+    MaterialEntry entries[MATERIAL_TABLE_SIZE];
+};
+
+extern const uint64_t MaterialKeys[32];
+
+int materialCount(uint64_t matkey, int colour, int piece);
+
+MaterialEntry* getMaterialEntry(MaterialTable *mtable, uint64_t matkey);
+void computeMaterialEntry(MaterialEntry *mentry, uint64_t matkey);
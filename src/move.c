@@ -25,6 +25,7 @@
 #include "board.h"
 #include "castle.h"
 #include "masks.h"
+#include "material.h"
 #include "move.h"
 #include "movegen.h"
 #include "psqt.h"
@@ -35,29 +36,30 @@
 
 int apply(Thread *thread, Board *board, uint16_t move, int height) {
 
-    int legal;
     Undo *undo = &thread->undoStack[height];
 
     // NULL moves are only tried when legal
     if (move == NULL_MOVE) {
         thread->moveStack[height] = NULL_MOVE;
+        thread->hashStack[height] = board->hash;
         applyNullMove(board, undo);
         return 1;
     }
 
-    // Apply and reject the move if illegal
+    // Let the search know to skip illegal moves, without ever applying them
+    if (!moveIsLegal(board, move))
+        return 0;
+
+    // Store hash history for repetition checking
+    thread->hashStack[height] = board->hash;
+
     applyMove(board, move, undo);
-    legal = isNotInCheck(board, !board->turn);
-    if (!legal) revertMove(board, move, undo);
 
     // Track each move and which piece type made it throughout the tree
-    if (legal) {
-        thread->moveStack[height] = move;
-        thread->pieceStack[height] = pieceType(board->squares[MoveTo(move)]);
-    }
+    thread->moveStack[height] = move;
+    thread->pieceStack[height] = pieceType(board->squares[MoveTo(move)]);
 
-    // Let the search know to skip this move
-    return legal;
+    return 1;
 }
 
 void applyMove(Board *board, uint16_t move, Undo *undo) {
@@ -69,17 +71,17 @@ void applyMove(Board *board, uint16_t move, Undo *undo) {
 
     undo->hash = board->hash;
     undo->pkhash = board->pkhash;
+    undo->matkey = board->matkey;
     undo->kingAttackers = board->kingAttackers;
     undo->castleRights = board->castleRights;
     undo->epSquare = board->epSquare;
     undo->fiftyMoveRule = board->fiftyMoveRule;
+    undo->pliesFromNull = board->pliesFromNull;
     undo->psqtmat = board->psqtmat;
 
-    // Store hash history for three-fold checking
-    board->history[board->numMoves++] = board->hash;
-
     // Always update fifty move, functions will reset
     board->fiftyMoveRule += 1;
+    board->pliesFromNull += 1;
 
     // Always update for turn and changes to enpass square
     board->hash ^= ZobristTurnKey;
@@ -132,6 +134,8 @@ void applyNormalMove(Board *board, uint16_t move, Undo *undo) {
                    -  PSQT[fromPiece][from]
                    -  PSQT[toPiece][to];
 
+    board->matkey  -= MaterialKeys[toPiece];
+
     board->hash    ^= ZobristKeys[fromPiece][from]
                    ^  ZobristKeys[fromPiece][to]
                    ^  ZobristKeys[toPiece][to];
@@ -227,6 +231,8 @@ void applyEnpassMove(Board *board, uint16_t move, Undo *undo) {
                     - PSQT[fromPiece][from]
                     - PSQT[enpassPiece][ep];
 
+    board->matkey  -= MaterialKeys[enpassPiece];
+
     board->hash    ^= ZobristKeys[fromPiece][from]
                    ^  ZobristKeys[fromPiece][to]
                    ^  ZobristKeys[enpassPiece][ep];
@@ -273,6 +279,10 @@ void applyPromotionMove(Board *board, uint16_t move, Undo *undo) {
                     - PSQT[fromPiece][from]
                     - PSQT[toPiece][to];
 
+    board->matkey  += MaterialKeys[promoPiece]
+                    - MaterialKeys[fromPiece]
+                    - MaterialKeys[toPiece];
+
     board->hash    ^= ZobristKeys[fromPiece][from]
                    ^  ZobristKeys[promoPiece][to]
                    ^  ZobristKeys[toPiece][to];
@@ -287,9 +297,9 @@ void applyNullMove(Board *board, Undo *undo) {
     undo->hash = board->hash;
     undo->epSquare = board->epSquare;
     undo->fiftyMoveRule = board->fiftyMoveRule;
+    undo->pliesFromNull = board->pliesFromNull;
 
     board->turn = !board->turn;
-    board->history[board->numMoves++] = board->hash;
 
     board->hash ^= ZobristTurnKey;
     if (board->epSquare != -1)
@@ -297,6 +307,7 @@ void applyNullMove(Board *board, Undo *undo) {
 
     board->epSquare = -1;
     board->fiftyMoveRule += 1;
+    board->pliesFromNull = 0;
 }
 
 void revert(Thread *thread, Board *board, uint16_t move, int height) {
@@ -311,13 +322,14 @@ void revertMove(Board *board, uint16_t move, Undo *undo) {
     const int from = MoveFrom(move);
 
     board->turn = !board->turn;
-    board->numMoves--;
     board->hash = undo->hash;
     board->pkhash = undo->pkhash;
+    board->matkey = undo->matkey;
     board->kingAttackers = undo->kingAttackers;
     board->castleRights = undo->castleRights;
     board->epSquare = undo->epSquare;
     board->fiftyMoveRule = undo->fiftyMoveRule;
+    board->pliesFromNull = undo->pliesFromNull;
     board->psqtmat = undo->psqtmat;
 
     if (MoveType(move) == NORMAL_MOVE){
@@ -395,7 +407,7 @@ void revertNullMove(Board *board, Undo *undo) {
     board->turn = !board->turn;
     board->epSquare = undo->epSquare;
     board->fiftyMoveRule = undo->fiftyMoveRule;
-    board->numMoves--;
+    board->pliesFromNull = undo->pliesFromNull;
 }
 
 void moveToString(uint16_t move, char *str) {
@@ -16,8 +16,9 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <stdint.h>
 #include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 #include "attacks.h"
 #include "board.h"
@@ -113,23 +114,160 @@ void buildKingMoves(uint16_t* moves, int* size, uint64_t pieces, uint64_t target
     buildNonPawnMoves(moves, size, kingAttacks(sq) & targets, sq);
 }
 
+void buildLegalPawnMoves(Board* board, uint16_t* moves, int* size, uint64_t pawns, uint64_t targets){
+
+    const uint64_t rank3Rel = board->turn == WHITE ? RANK_3 : RANK_6;
+    const int forwardShift  = board->turn == WHITE ? -8 : 8;
+    const int leftShift     = board->turn == WHITE ? -7 : 7;
+    const int rightShift    = board->turn == WHITE ? -9 : 9;
+
+    uint64_t enemy    = board->colours[!board->turn];
+    uint64_t occupied = board->colours[board->turn] | enemy;
+
+    // Compute bitboards for each type of pawn movement, except enpass
+    uint64_t pawnForwardOne = pawnAdvance(pawns, occupied, board->turn);
+    uint64_t pawnForwardTwo = pawnAdvance(pawnForwardOne & rank3Rel, occupied, board->turn);
+    uint64_t pawnLeft       = pawnLeftAttacks(pawns, enemy, board->turn);
+    uint64_t pawnRight      = pawnRightAttacks(pawns, enemy, board->turn);
+
+    pawnForwardOne &= targets; pawnForwardTwo &= targets;
+    pawnLeft       &= targets; pawnRight      &= targets;
+
+    buildPawnMoves(moves, size, pawnLeft & ~PROMOTION_RANKS, leftShift);
+    buildPawnMoves(moves, size, pawnRight & ~PROMOTION_RANKS, rightShift);
+    buildPawnMoves(moves, size, pawnForwardOne & ~PROMOTION_RANKS, forwardShift);
+    buildPawnMoves(moves, size, pawnForwardTwo, forwardShift * 2);
+
+    buildPawnPromotions(moves, size, pawnForwardOne & PROMOTION_RANKS, forwardShift);
+    buildPawnPromotions(moves, size, pawnLeft & PROMOTION_RANKS, leftShift);
+    buildPawnPromotions(moves, size, pawnRight & PROMOTION_RANKS, rightShift);
+}
+
 
 /* For Building Full Move Lists */
 
 void genAllLegalMoves(Board* board, uint16_t* moves, int* size){
 
+    const int US = board->turn, THEM = !board->turn;
+
     Undo undo[1];
-    int i, psuedoSize = 0;
-    uint16_t psuedoMoves[MAX_MOVES];
+    int sq, ksq, pinner;
+    uint64_t targets, pinned = 0ull, snipers, between, pawnEnpass;
+    uint64_t pinRays[SQUARE_NB];
+
+    uint64_t friendly = board->colours[US];
+    uint64_t enemy    = board->colours[THEM];
+    uint64_t occupied = friendly | enemy;
+
+    uint64_t myPawns   = friendly &  board->pieces[PAWN];
+    uint64_t myKnights = friendly &  board->pieces[KNIGHT];
+    uint64_t myBishops = friendly & (board->pieces[BISHOP] | board->pieces[QUEEN]);
+    uint64_t myRooks   = friendly & (board->pieces[ROOK]   | board->pieces[QUEEN]);
+
+    uint64_t enemyBishops = enemy & (board->pieces[BISHOP] | board->pieces[QUEEN]);
+    uint64_t enemyRooks   = enemy & (board->pieces[ROOK]   | board->pieces[QUEEN]);
+
+    ksq = getlsb(friendly & board->pieces[KING]);
+
+    // King moves are legal when the target is not attacked. We lift the King
+    // from the board, so that it does not shield a square from a slider
+    targets = kingAttacks(ksq) & ~friendly;
+    while (targets) {
+        sq = poplsb(&targets);
+        if (!squareIsAttackedWith(board, US, sq, occupied ^ (1ull << ksq)))
+            moves[(*size)++] = MoveMake(ksq, sq, NORMAL_MOVE);
+    }
+
+    // When in double check, only the King may move
+    if (several(board->kingAttackers)) return;
+
+    // When in check, other pieces must either capture or block the checker
+    targets = ~friendly;
+    if (board->kingAttackers)
+        targets &= board->kingAttackers | bitsBetweenMasks(ksq, getlsb(board->kingAttackers));
+
+    // Find our pieces which are pinned to the King. Look from the King through
+    // only enemy pieces, to find sliders with exactly one of our pieces between
+    snipers = (bishopAttacks(ksq, enemy) & enemyBishops)
+            | (rookAttacks(ksq, enemy) & enemyRooks);
+
+    while (snipers) {
+        pinner  = poplsb(&snipers);
+        between = bitsBetweenMasks(ksq, pinner) & occupied;
+        if (onlyOne(between) && (between & friendly)) {
+            pinned |= between;
+            pinRays[getlsb(between)] = bitsBetweenMasks(ksq, pinner) | (1ull << pinner);
+        }
+    }
+
+    // Generate moves for all unpinned pieces, which may go anywhere
+    buildLegalPawnMoves(board, moves, size, myPawns & ~pinned, targets);
+    buildKnightMoves(moves, size, myKnights & ~pinned, targets);
+    buildBishopAndQueenMoves(moves, size, myBishops & ~pinned, occupied, targets);
+    buildRookAndQueenMoves(moves, size, myRooks & ~pinned, occupied, targets);
+
+    // Generate moves for pinned pieces, which must stay on the line of the pin.
+    // Pinned Knights can never move, and pinned pieces can never resolve a check
+    if (!board->kingAttackers) {
+
+        uint64_t pieces = pinned & ~myKnights;
+
+        while (pieces) {
+            sq = poplsb(&pieces);
+
+            if (testBit(myPawns, sq))
+                buildLegalPawnMoves(board, moves, size, 1ull << sq, pinRays[sq]);
+
+            if (testBit(myBishops, sq))
+                buildBishopAndQueenMoves(moves, size, 1ull << sq, occupied, targets & pinRays[sq]);
+
+            if (testBit(myRooks, sq))
+                buildRookAndQueenMoves(moves, size, 1ull << sq, occupied, targets & pinRays[sq]);
+        }
+    }
+
+    // Enpass captures remove two pieces from a single rank, which makes the
+    // legality difficult to verify directly. They are rare, so simply apply them
+    pawnEnpass = pawnEnpassCaptures(myPawns, board->epSquare, US);
+    while (pawnEnpass) {
+        uint16_t move = MoveMake(poplsb(&pawnEnpass), board->epSquare, ENPASS_MOVE);
+        applyMove(board, move, undo);
+        if (isNotInCheck(board, US)) moves[(*size)++] = move;
+        revertMove(board, move, undo);
+    }
 
-    genAllMoves(board, psuedoMoves, &psuedoSize);
+    // Castling requires that neither the King's path nor its target is attacked
+    if (!board->kingAttackers) {
 
-    // Check each move for legality before copying
-    for (i = 0; i < psuedoSize; i++){
-        applyMove(board, psuedoMoves[i], undo);
-        if (isNotInCheck(board, !board->turn))
-            moves[(*size)++] = psuedoMoves[i];
-        revertMove(board, psuedoMoves[i], undo);
+        if (US == WHITE) {
+
+            if (  ((occupied & WHITE_CASTLE_KING_SIDE_MAP) == 0)
+                && (board->castleRights & WHITE_KING_RIGHTS)
+                && !squareIsAttacked(board, WHITE, 5)
+                && !squareIsAttacked(board, WHITE, 6))
+                moves[(*size)++] = MoveMake(4, 6, CASTLE_MOVE);
+
+            if (  ((occupied & WHITE_CASTLE_QUEEN_SIDE_MAP) == 0)
+                && (board->castleRights & WHITE_QUEEN_RIGHTS)
+                && !squareIsAttacked(board, WHITE, 3)
+                && !squareIsAttacked(board, WHITE, 2))
+                moves[(*size)++] = MoveMake(4, 2, CASTLE_MOVE);
+        }
+
+        else {
+
+            if (  ((occupied & BLACK_CASTLE_KING_SIDE_MAP) == 0)
+                && (board->castleRights & BLACK_KING_RIGHTS)
+                && !squareIsAttacked(board, BLACK, 61)
+                && !squareIsAttacked(board, BLACK, 62))
+                moves[(*size)++] = MoveMake(60, 62, CASTLE_MOVE);
+
+            if (  ((occupied & BLACK_CASTLE_QUEEN_SIDE_MAP) == 0)
+                && (board->castleRights & BLACK_QUEEN_RIGHTS)
+                && !squareIsAttacked(board, BLACK, 59)
+                && !squareIsAttacked(board, BLACK, 58))
+                moves[(*size)++] = MoveMake(60, 58, CASTLE_MOVE);
+        }
     }
 }
 
@@ -311,18 +449,168 @@ void genAllQuietMoves(Board* board, uint16_t* moves, int* size){
     }
 }
 
+void genAllQuietChecks(Board* board, uint16_t* moves, int* size){
+
+    const int US = board->turn, THEM = !board->turn;
+    const uint64_t rank3Rel = US == WHITE ? RANK_3 : RANK_6;
+    const int forwardShift  = US == WHITE ?     -8 :      8;
+
+    int sq, eksq, slider;
+    uint64_t snipers, between, attacks, checks, forwardOne, forwardTwo;
+    uint64_t discovered = 0ull, rays[SQUARE_NB];
+
+    uint64_t friendly = board->colours[US];
+    uint64_t enemy    = board->colours[THEM];
+    uint64_t occupied = friendly | enemy;
+    uint64_t empty    = ~occupied;
+
+    uint64_t myPawns   = friendly &  board->pieces[PAWN];
+    uint64_t myKnights = friendly &  board->pieces[KNIGHT];
+    uint64_t myBishops = friendly & (board->pieces[BISHOP] | board->pieces[QUEEN]);
+    uint64_t myRooks   = friendly & (board->pieces[ROOK]   | board->pieces[QUEEN]);
+    uint64_t myKings   = friendly &  board->pieces[KING];
+
+    // Evasions are generated elsewhere, and we have no use for checks there
+    assert(!board->kingAttackers);
+
+    eksq = getlsb(enemy & board->pieces[KING]);
+
+    // Squares from which each type of piece would attack the enemy King
+    uint64_t pawnChecks   = pawnAttacks(THEM, eksq) & empty;
+    uint64_t knightChecks = knightAttacks(eksq) & empty;
+    uint64_t bishopChecks = bishopAttacks(eksq, occupied) & empty;
+    uint64_t rookChecks   = rookAttacks(eksq, occupied) & empty;
+
+    // Find our pieces which are the only blocker between one of our sliders
+    // and the enemy King. Moving such a piece off of the line reveals a check
+    snipers = (bishopAttacks(eksq, 0ull) & myBishops)
+            | (rookAttacks(eksq, 0ull) & myRooks);
+
+    while (snipers) {
+        slider  = poplsb(&snipers);
+        between = bitsBetweenMasks(eksq, slider) & occupied;
+        if (onlyOne(between) && (between & friendly)) {
+            discovered |= between;
+            rays[getlsb(between)] = bitsBetweenMasks(eksq, slider);
+        }
+    }
+
+    // Pawn advances, excluding promotions which are already noisy
+    for (uint64_t pawns = myPawns; pawns; ) {
+        sq = poplsb(&pawns);
+        checks = pawnChecks | (testBit(discovered, sq) ? empty & ~rays[sq] : 0ull);
+        forwardOne = pawnAdvance(1ull << sq, occupied, US) & ~PROMOTION_RANKS;
+        forwardTwo = pawnAdvance(forwardOne & rank3Rel, occupied, US);
+        buildPawnMoves(moves, size, forwardOne & checks, forwardShift);
+        buildPawnMoves(moves, size, forwardTwo & checks, forwardShift * 2);
+    }
+
+    // Knights always leave the line of a discovered check when moving
+    for (uint64_t knights = myKnights; knights; ) {
+        sq = poplsb(&knights);
+        checks = testBit(discovered, sq) ? empty : knightChecks;
+        buildNonPawnMoves(moves, size, knightAttacks(sq) & checks, sq);
+    }
+
+    // Bishops, Rooks, and Queens. Queens check along both kinds of lines
+    for (uint64_t sliders = myBishops | myRooks; sliders; ) {
+        sq = poplsb(&sliders);
+        attacks = checks = 0ull;
+
+        if (testBit(myBishops, sq)) {
+            attacks |= bishopAttacks(sq, occupied);
+            checks  |= bishopChecks;
+        }
+
+        if (testBit(myRooks, sq)) {
+            attacks |= rookAttacks(sq, occupied);
+            checks  |= rookChecks;
+        }
+
+        if (testBit(discovered, sq))
+            checks |= empty & ~rays[sq];
+
+        buildNonPawnMoves(moves, size, attacks & checks, sq);
+    }
+
+    // The King may only ever give a discovered check. We don't bother to
+    // generate castles which give check, since they are quite rare
+    if (discovered & myKings) {
+        sq = getlsb(myKings);
+        buildNonPawnMoves(moves, size, kingAttacks(sq) & empty & ~rays[sq], sq);
+    }
+}
+
 int isNotInCheck(Board* board, int colour){
     int kingsq = getlsb(board->colours[colour] & board->pieces[KING]);
     assert(board->squares[kingsq] == WHITE_KING + colour);
     return !squareIsAttacked(board, colour, kingsq);
 }
 
-int squareIsAttacked(Board* board, int colour, int sq){
+int moveIsLegal(Board* board, uint16_t move){
 
-    uint64_t friendly = board->colours[ colour];
-    uint64_t enemy    = board->colours[!colour];
+    const int US = board->turn, THEM = !board->turn;
+
+    int legal, ksq, from = MoveFrom(move), to = MoveTo(move);
+    Undo undo[1];
+
+    uint64_t friendly = board->colours[US];
+    uint64_t enemy    = board->colours[THEM];
     uint64_t occupied = friendly | enemy;
 
+    assert(move != NONE_MOVE && move != NULL_MOVE);
+
+    // Enpass captures remove two pieces from a single rank, which makes the
+    // legality difficult to verify directly. They are rare, so simply apply them
+    if (MoveType(move) == ENPASS_MOVE) {
+        applyMove(board, move, undo);
+        legal = isNotInCheck(board, US);
+        revertMove(board, move, undo);
+        return legal;
+    }
+
+    // Castles have already verified the path of the King, but not the target
+    if (MoveType(move) == CASTLE_MOVE)
+        return !squareIsAttacked(board, US, to);
+
+    ksq = getlsb(friendly & board->pieces[KING]);
+
+    // King moves are legal when the target is not attacked. We lift the King
+    // from the board, so that it does not shield a square from a slider
+    if (from == ksq)
+        return !squareIsAttackedWith(board, US, to, occupied ^ (1ull << ksq));
+
+    // When in check, other pieces must either capture or block the checker
+    if (board->kingAttackers) {
+
+        if (several(board->kingAttackers))
+            return 0;
+
+        if (!testBit(board->kingAttackers | bitsBetweenMasks(ksq, getlsb(board->kingAttackers)), to))
+            return 0;
+    }
+
+    // A piece which is not on a line with our King can never be pinned
+    if (   fileOf(from) != fileOf(ksq) && rankOf(from) != rankOf(ksq)
+        && abs(fileOf(from) - fileOf(ksq)) != abs(rankOf(from) - rankOf(ksq)))
+        return 1;
+
+    // Otherwise, make sure that no slider is revealed onto our King
+    occupied = (occupied ^ (1ull << from)) | (1ull << to);
+    enemy   &= ~(1ull << to);
+
+    return !(bishopAttacks(ksq, occupied) & enemy & (board->pieces[BISHOP] | board->pieces[QUEEN]))
+        && !(rookAttacks(ksq, occupied) & enemy & (board->pieces[ROOK] | board->pieces[QUEEN]));
+}
+
+int squareIsAttacked(Board* board, int colour, int sq){
+    return squareIsAttackedWith(board, colour, sq, board->colours[WHITE] | board->colours[BLACK]);
+}
+
+int squareIsAttackedWith(Board* board, int colour, int sq, uint64_t occupied){
+
+    uint64_t enemy = board->colours[!colour];
+
     uint64_t enemyPawns   = enemy &  board->pieces[PAWN  ];
     uint64_t enemyKnights = enemy &  board->pieces[KNIGHT];
     uint64_t enemyBishops = enemy & (board->pieces[BISHOP] | board->pieces[QUEEN]);
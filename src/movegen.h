@@ -33,9 +33,12 @@ void genAllLegalMoves(Board* board, uint16_t* moves, int* size);
 void genAllMoves(Board* board, uint16_t* moves, int* size);
 void genAllNoisyMoves(Board* board, uint16_t* moves, int* size);
 void genAllQuietMoves(Board* board, uint16_t* moves, int* size);
+void genAllQuietChecks(Board* board, uint16_t* moves, int* size);
 
 int isNotInCheck(Board* board, int colour);
+int moveIsLegal(Board* board, uint16_t move);
 int squareIsAttacked(Board* board, int colour, int sq);
+int squareIsAttackedWith(Board* board, int colour, int sq, uint64_t occupied);
 
 uint64_t attackersToSquare(Board* board, int colour, int sq);
 uint64_t allAttackersToSquare(Board* board, uint64_t occupied, int sq);
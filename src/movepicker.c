@@ -54,9 +54,15 @@ void initMovePicker(MovePicker* mp, Thread* thread, uint16_t ttMove, int height)
 
     // Normal picker returns bad noisy moves
     mp->type = NORMAL_PICKER;
+
+    // No SEE has been computed yet
+    mp->seeMove = NONE_MOVE;
+
+    // Quiet checks are only for the noisy picker
+    mp->checks = 0;
 }
 
-void initNoisyMovePicker(MovePicker* mp, Thread* thread, int threshold){
+void initNoisyMovePicker(MovePicker* mp, Thread* thread, int threshold, int height, int checks){
 
     // Start with just the noisy moves
     mp->stage = STAGE_GENERATE_NOISY;
@@ -73,16 +79,21 @@ void initNoisyMovePicker(MovePicker* mp, Thread* thread, int threshold){
     // Reference to the board
     mp->thread = thread;
 
-    // No stats used, set to 0 to be safe
-    mp->height = 0;
+    // Reference for the attack maps
+    mp->height = height;
 
     // Noisy picker skips bad noisy moves
     mp->type = NOISY_PICKER;
+
+    // No SEE has been computed yet
+    mp->seeMove = NONE_MOVE;
+
+    // Noisy picker may try quiet checks after the noisy moves
+    mp->checks = checks;
 }
 
 uint16_t selectNextMove(MovePicker* mp, Board* board, int skipQuiets){
 
-    int best;
     uint16_t bestMove;
 
     switch (mp->stage){
@@ -101,60 +112,54 @@ uint16_t selectNextMove(MovePicker* mp, Board* board, int skipQuiets){
         // Generate and evaluate noisy moves. mp->split tracks the
         // break point between noisy and quiets, which allows us
         // to use a BAD_NOISY stage, where we skip noisy moves which
-        // fail a simple SEE, and try them after all quiet moves
+        // fail a simple SEE, and try them after all quiet moves. When
+        // in check, both the noisy and quiet evasions are made here
+
+        if (mp->type == NORMAL_PICKER && board->kingAttackers)
+            genEvasions(mp, board);
+
+        else {
+            mp->noisySize = 0;
+            genAllNoisyMoves(board, mp->moves, &mp->noisySize);
+            evaluateNoisyMoves(mp);
+            sortMoves(mp->values, 0, mp->noisySize);
+            mp->split = mp->noisySize;
+        }
 
-        mp->noisySize = 0;
-        genAllNoisyMoves(board, mp->moves, &mp->noisySize);
-        evaluateNoisyMoves(mp);
-        mp->split = mp->noisySize;
+        mp->cursor = mp->badSize = 0;
         mp->stage = STAGE_GOOD_NOISY;
 
         /* fallthrough */
 
     case STAGE_GOOD_NOISY:
 
-        // Check to see if there are still more noisy moves
-        if (mp->noisySize != 0){
-
-            // Select next best MVV-LVA from the noisy moves
-            best = getBestMoveIndex(mp, 0, mp->noisySize);
-            bestMove = mp->moves[best];
-
-            // Values below zero are flagged as failing an SEE (bad noisy)
-            if (mp->values[best] >= 0) {
-
-                // Skip bad noisy moves during this stage
-                if (!staticExchangeEvaluation(board, bestMove, mp->threshold)){
+        // Noisy moves were sorted by MVV-LVA, so simply walk through them
+        while (mp->cursor < mp->noisySize) {
 
-                    // Flag for failed use in STAGE_BAD_NOISY
-                    mp->values[best] = -1;
+            bestMove = mp->moves[unpackIndex(mp->values[mp->cursor])];
 
-                    // Try again to find a noisy move passing SEE
-                    return selectNextMove(mp, board, skipQuiets);
-                }
-
-                // Reduce effective move list size
-                mp->noisySize -= 1;
-                mp->moves[best] = mp->moves[mp->noisySize];
-                mp->values[best] = mp->values[mp->noisySize];
+            // Don't play the table move twice
+            if (bestMove == mp->tableMove) {
+                mp->cursor++;
+                continue;
+            }
 
-                // Don't play the table move twice
-                if (bestMove == mp->tableMove)
-                    return selectNextMove(mp, board, skipQuiets);
+            // Save moves which fail the SEE for use in STAGE_BAD_NOISY.
+            // They are packed at the front, and so remain in sorted order
+            if (!moveSEE(mp, bestMove, mp->threshold)) {
+                mp->seeValues[mp->badSize] = mp->seeMove == bestMove ? mp->seeValue : VALUE_NONE;
+                mp->values[mp->badSize++] = mp->values[mp->cursor++];
+                continue;
+            }
 
-                // Don't play the special moves twice
-                if (bestMove == mp->killer1) mp->killer1 = NONE_MOVE;
-                if (bestMove == mp->killer2) mp->killer2 = NONE_MOVE;
-                if (bestMove == mp->counter) mp->counter = NONE_MOVE;
+            mp->cursor++;
 
-                return bestMove;
-            }
-        }
+            // Don't play the special moves twice
+            if (bestMove == mp->killer1) mp->killer1 = NONE_MOVE;
+            if (bestMove == mp->killer2) mp->killer2 = NONE_MOVE;
+            if (bestMove == mp->counter) mp->counter = NONE_MOVE;
 
-        // Jump to bad noisy moves when skipping quiets
-        if (skipQuiets){
-            mp->stage = STAGE_BAD_NOISY;
-            return selectNextMove(mp, board, skipQuiets);
+            return bestMove;
         }
 
         mp->stage = STAGE_KILLER_1;
@@ -198,78 +203,97 @@ uint16_t selectNextMove(MovePicker* mp, Board* board, int skipQuiets){
 
     case STAGE_GENERATE_QUIET:
 
-        // Generate and evaluate all quiet moves when not skipping quiet moves
-        if (!skipQuiets){
+        // Generate and evaluate all quiet moves when not skipping quiet moves,
+        // unless they were already produced along with the evasions
+        if (!(mp->type == NORMAL_PICKER && board->kingAttackers)) {
             mp->quietSize = 0;
-            genAllQuietMoves(board, mp->moves + mp->split, &mp->quietSize);
-            evaluateQuietMoves(mp);
+            if (!skipQuiets) {
+                genAllQuietMoves(board, mp->moves + mp->split, &mp->quietSize);
+                evaluateQuietMoves(mp);
+            }
         }
 
+        mp->cursor = mp->split;
         mp->stage = STAGE_QUIET;
 
         /* fallthrough */
 
     case STAGE_QUIET:
 
-        // Check to see if there are still more quiet moves
-        if (!skipQuiets && mp->quietSize){
+        // Select the quiet move with the best history score among those left
+        while (!skipQuiets && mp->cursor < mp->split + mp->quietSize) {
 
-            // Select next best quiet by history scores
-            best = getBestMoveIndex(mp, mp->split, mp->split + mp->quietSize);
-
-            // Save the best move before overwriting it
-            bestMove = mp->moves[best];
-
-            // Reduce effective move list size
-            mp->quietSize--;
-            mp->moves[best] = mp->moves[mp->split + mp->quietSize];
-            mp->values[best] = mp->values[mp->split + mp->quietSize];
+            selectBest(mp->values, mp->cursor, mp->split + mp->quietSize);
+            bestMove = mp->moves[unpackIndex(mp->values[mp->cursor++])];
 
             // Don't play a move more than once
             if (   bestMove == mp->tableMove
                 || bestMove == mp->killer1
                 || bestMove == mp->killer2
                 || bestMove == mp->counter)
-                return selectNextMove(mp, board, skipQuiets);
+                continue;
 
             return bestMove;
         }
 
-        // Out of quiet moves, only bad quiets remain
+        // Out of quiet moves, only bad noisy moves remain
+        mp->cursor = 0;
         mp->stage = STAGE_BAD_NOISY;
 
         /* fallthrough */
 
     case STAGE_BAD_NOISY:
 
-        // Noisy picker skips all bad noisy moves
-        if (mp->type == NOISY_PICKER) {
+        // Noisy picker skips all bad noisy moves, but may try quiet checks
+        if (mp->type == NORMAL_PICKER) {
+
+            while (mp->cursor < mp->badSize) {
+
+                bestMove = mp->moves[unpackIndex(mp->values[mp->cursor++])];
+
+                // Don't play a move more than once
+                if (   bestMove == mp->killer1
+                    || bestMove == mp->killer2
+                    || bestMove == mp->counter)
+                    continue;
+
+                // Restore the exact SEE, if it was needed in STAGE_GOOD_NOISY
+                mp->seeMove  = mp->seeValues[mp->cursor-1] != VALUE_NONE ? bestMove : NONE_MOVE;
+                mp->seeValue = mp->seeValues[mp->cursor-1];
+
+                return bestMove;
+            }
+
+            // Out of all captures and quiet moves, move picker complete
             mp->stage = STAGE_DONE;
             return NONE_MOVE;
         }
 
-        // Check to see if there are still more noisy moves
-        if (mp->noisySize != 0){
+        mp->stage = mp->checks ? STAGE_GENERATE_CHECKS : STAGE_DONE;
+        if (mp->stage == STAGE_DONE) return NONE_MOVE;
 
-            // Save the best move before overwriting it
-            bestMove = mp->moves[0];
+        /* fallthrough */
 
-            // Reduce effective move list size
-            mp->noisySize -= 1;
-            mp->moves[0] = mp->moves[mp->noisySize];
-            mp->values[0] = mp->values[mp->noisySize];
+    case STAGE_GENERATE_CHECKS:
 
-            // Don't play a move more than once
-            if (   bestMove == mp->tableMove
-                || bestMove == mp->killer1
-                || bestMove == mp->killer2
-                || bestMove == mp->counter)
-                return selectNextMove(mp, board, skipQuiets);
+        // Generate the quiet moves which give check. These are not ordered,
+        // since only a handful exist and most of them fail the SEE below
+        mp->quietSize = 0;
+        genAllQuietChecks(board, mp->moves + mp->split, &mp->quietSize);
+        mp->cursor = mp->split;
+        mp->stage = STAGE_QUIET_CHECKS;
 
-            return bestMove;
+        /* fallthrough */
+
+    case STAGE_QUIET_CHECKS:
+
+        // Only return quiet checks which do not lose material
+        while (mp->cursor < mp->split + mp->quietSize) {
+            bestMove = mp->moves[mp->cursor++];
+            if (moveSEE(mp, bestMove, 0))
+                return bestMove;
         }
 
-        // Out of all captures and quiet moves, move picker complete
         mp->stage = STAGE_DONE;
 
         /* fallthrough */
@@ -283,20 +307,89 @@ uint16_t selectNextMove(MovePicker* mp, Board* board, int skipQuiets){
     }
 }
 
-int getBestMoveIndex(MovePicker *mp, int start, int end) {
+int moveSEE(MovePicker* mp, uint16_t move, int threshold) {
+
+    Board *board = &mp->thread->board;
+    int best, worst;
+
+    // The exact SEE of the most recent move is saved, since the search often
+    // asks about the same move again, but with a different threshold
+    if (move == mp->seeMove)
+        return mp->seeValue >= threshold;
+
+    // The exchange is worth at most the value of the move itself, and at
+    // least that less the moving piece, as either side may stop capturing.
+    // Most calls are decided by these bounds, without finding attackers
+    best  = thisTacticalMoveValue(board, move);
+    worst = best - (MoveType(move) != PROMOTION_MOVE
+                 ? SEEPieceValues[pieceType(board->squares[MoveFrom(move)])]
+                 : SEEPieceValues[MovePromoPiece(move)]);
+
+    if (best < threshold) return 0;
+    if (worst >= threshold) return 1;
+
+    mp->seeMove  = move;
+    mp->seeValue = staticExchangeValue(board, move, &mp->thread->attackStack[mp->height]);
+    return mp->seeValue >= threshold;
+}
+
+void genEvasions(MovePicker* mp, Board* board) {
+
+    uint16_t move;
+
+    // When in check, generate only the legal evasions. These are split
+    // into the noisy and quiet moves, so that the remaining stages can
+    // order and return them exactly as they would without the check
+    mp->noisySize = mp->quietSize = 0;
+    genAllLegalMoves(board, mp->moves, &mp->quietSize);
+
+    for (int i = 0; i < mp->quietSize; i++) {
+        if (moveIsTactical(board, mp->moves[i])) {
+            move = mp->moves[i];
+            mp->moves[i] = mp->moves[mp->noisySize];
+            mp->moves[mp->noisySize++] = move;
+        }
+    }
+
+    mp->split = mp->noisySize;
+    mp->quietSize -= mp->noisySize;
+
+    evaluateNoisyMoves(mp);
+    evaluateQuietMoves(mp);
+    sortMoves(mp->values, 0, mp->noisySize);
+}
+
+void selectBest(int* values, int start, int end) {
 
-    int best = start;
+    int best = start, value;
 
+    // Find the largest packed value, and swap it to the front
     for (int i = start + 1; i < end; i++)
-        if (mp->values[i] > mp->values[best])
+        if (values[i] > values[best])
             best = i;
 
-    return best;
+    value = values[start];
+    values[start] = values[best];
+    values[best] = value;
+}
+
+void sortMoves(int* values, int start, int end) {
+
+    int value, j;
+
+    // Insertion sort, descending. Values are packed with a unique index,
+    // so a plain integer comparison is all that is needed
+    for (int i = start + 1; i < end; i++) {
+        value = values[i];
+        for (j = i; j > start && values[j-1] < value; j--)
+            values[j] = values[j-1];
+        values[j] = value;
+    }
 }
 
 void evaluateNoisyMoves(MovePicker* mp){
 
-    int fromType, toType;
+    int value, fromType, toType;
 
     // Use modified MVV-LVA to evaluate moves
     for (int i = 0; i < mp->noisySize; i++){
@@ -305,30 +398,48 @@ void evaluateNoisyMoves(MovePicker* mp){
         toType   = pieceType(mp->thread->board.squares[MoveTo(mp->moves[i])]);
 
         // Use the standard MVV-LVA
-        mp->values[i] = PieceValues[toType][EG] - fromType;
+        value = PieceValues[toType][EG] - fromType;
 
         // A bonus is in order for queen promotions
         if ((mp->moves[i] & QUEEN_PROMO_MOVE) == QUEEN_PROMO_MOVE)
-            mp->values[i] += PieceValues[QUEEN][EG];
+            value += PieceValues[QUEEN][EG];
 
         // Enpass is a special case of MVV-LVA
         else if (MoveType(mp->moves[i]) == ENPASS_MOVE)
-            mp->values[i] = PieceValues[PAWN][EG] - PAWN;
+            value = PieceValues[PAWN][EG] - PAWN;
 
-        // Later we will flag moves which were passed over in the STAGE_GOOD_NOISY
-        // phase due to failing an SEE(0), by setting the value to -1
-        assert(mp->values[i] >= 0);
+        mp->values[i] = packValue(value, i);
     }
 }
 
 void evaluateQuietMoves(MovePicker* mp){
 
+    Board *board = &mp->thread->board;
+    AttackMaps *maps = &mp->thread->attackStack[mp->height];
+    uint64_t threatened = 0ull;
+    int value;
+
+    // If the evaluation computed attack maps for this position, find the squares
+    // where a piece would be attacked by a pawn, or attacked and not defended
+    if (maps->hash == board->hash)
+        threatened =  maps->pawnAttacks[!board->turn]
+                   | (maps->attacked[!board->turn] & ~maps->attacked[board->turn]);
+
     // Sort moves based on Butterfly history, Counter
     // Move History, as well as Follow Up Move History.
-    for (int i = mp->split; i < mp->split + mp->quietSize; i++)
-        mp->values[i] = getHistoryScore(mp->thread, mp->moves[i])
-                      + getCMHistoryScore(mp->thread, mp->height, mp->moves[i])
-                      + getFUHistoryScore(mp->thread, mp->height, mp->moves[i]);
+    for (int i = mp->split; i < mp->split + mp->quietSize; i++) {
+
+        value = getHistoryScore(mp->thread, mp->moves[i])
+              + getCMHistoryScore(mp->thread, mp->height, mp->moves[i])
+              + getFUHistoryScore(mp->thread, mp->height, mp->moves[i]);
+
+        // Penalize pieces which move onto threatened squares
+        if (    testBit(threatened, MoveTo(mp->moves[i]))
+            &&  pieceType(board->squares[MoveFrom(mp->moves[i])]) != PAWN)
+            value -= QuietThreatPenalty;
+
+        mp->values[i] = packValue(value, i);
+    }
 }
 
 int moveIsPsuedoLegal(Board* board, uint16_t move){
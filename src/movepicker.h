@@ -27,6 +27,7 @@ enum {
     STAGE_KILLER_1, STAGE_KILLER_2, STAGE_COUNTER_MOVE,
     STAGE_GENERATE_QUIET, STAGE_QUIET,
     STAGE_BAD_NOISY,
+    STAGE_GENERATE_CHECKS, STAGE_QUIET_CHECKS,
     STAGE_DONE,
 };
 
@@ -36,20 +37,36 @@ enum {
 };
 
 struct MovePicker {
-    int split, noisySize, quietSize;
-    int stage, height, type, threshold;
-    int values[MAX_MOVES];
+    int split, noisySize, quietSize, badSize, cursor;
+    int stage, height, type, threshold, checks;
+    int values[MAX_MOVES], seeValues[MAX_MOVES], seeValue;
     uint16_t moves[MAX_MOVES];
-    uint16_t tableMove, killer1, killer2, counter;
+    uint16_t tableMove, killer1, killer2, counter, seeMove;
     Thread *thread;
 };
 
 void initMovePicker(MovePicker* mp, Thread* thread, uint16_t ttMove, int height);
-void initNoisyMovePicker(MovePicker* mp, Thread* thread, int threshold);
+void initNoisyMovePicker(MovePicker* mp, Thread* thread, int threshold, int height, int checks);
 uint16_t selectNextMove(MovePicker* mp, Board* board, int skipQuiets);
-int getBestMoveIndex(MovePicker *mp, int start, int end);
+int moveSEE(MovePicker* mp, uint16_t move, int threshold);
+void genEvasions(MovePicker* mp, Board* board);
+void selectBest(int* values, int start, int end);
+void sortMoves(int* values, int start, int end);
 void evaluateNoisyMoves(MovePicker* mp);
 void evaluateQuietMoves(MovePicker* mp);
 int moveIsPsuedoLegal(Board* board, uint16_t move);
 
+static const int QuietThreatPenalty = 4096;
+
+// Scores are packed with the index of their move into a single integer. The
+// index is inverted, so that equal scores are sorted in the generated order
+
+static inline int packValue(int value, int index) {
+    return value * MAX_MOVES + (MAX_MOVES - 1 - index);
+}
+
+static inline int unpackIndex(int value) {
+    return MAX_MOVES - 1 - (value & (MAX_MOVES - 1));
+}
+
 #endif
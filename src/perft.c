@@ -0,0 +1,369 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <inttypes.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "move.h"
+#include "movegen.h"
+#include "perft.h"
+#include "search.h"
+#include "time.h"
+#include "types.h"
+
+typedef struct PerftJob {
+    Board *board;
+    PerftTable *ptable;
+    pthread_mutex_t lock;
+    int depth, next, size;
+    uint16_t moves[MAX_MOVES];
+    uint64_t counts[MAX_MOVES];
+} PerftJob;
+
+typedef struct PerftTest {
+    char fen[128];
+    int depth;
+    uint64_t expected, found;
+} PerftTest;
+
+typedef struct PerftSuite {
+    PerftTest *tests;
+    PerftTable *ptable;
+    pthread_mutex_t lock;
+    int next, size;
+} PerftSuite;
+
+void initPerftTable(PerftTable *ptable, uint64_t megabytes) {
+
+    uint64_t entries = 1ull;
+
+    // Scale down the table to the closest power of 2, at or below megabytes
+    while ((entries << 1) * sizeof(PerftEntry) <= megabytes << 20)
+        entries <<= 1;
+
+    ptable->entries  = calloc(entries, sizeof(PerftEntry));
+    ptable->hashMask = entries - 1u;
+}
+
+void freePerftTable(PerftTable *ptable) {
+    free(ptable->entries);
+}
+
+static int getPerftEntry(PerftTable *ptable, uint64_t hash, int depth, uint64_t *nodes) {
+
+    // Copy the entry out, since other threads may write to it at any time
+    PerftEntry entry = ptable->entries[hash & ptable->hashMask];
+
+    // Entries are stored with the data xor'ed into the key, so that a
+    // torn entry fails to validate. Depth is held in the lowest byte
+    if ((entry.key ^ entry.data) != hash || (int)(entry.data & 0xFF) != depth)
+        return 0;
+
+    *nodes = entry.data >> 8;
+    return 1;
+}
+
+static void storePerftEntry(PerftTable *ptable, uint64_t hash, int depth, uint64_t nodes) {
+
+    PerftEntry *entry = &ptable->entries[hash & ptable->hashMask];
+
+    entry->data = (nodes << 8) | (uint64_t)depth;
+    entry->key  = hash ^ entry->data;
+}
+
+uint64_t perftHashed(Board *board, int depth, PerftTable *ptable) {
+
+    Undo undo[1];
+    int size = 0;
+    uint64_t found = 0ull;
+    uint16_t moves[MAX_MOVES];
+
+    if (depth == 0) return 1ull;
+
+    // Small subtrees are cheaper to recount than to look up
+    if (depth >= 2 && getPerftEntry(ptable, board->hash, depth, &found))
+        return found;
+
+    genAllLegalMoves(board, moves, &size);
+
+    // Bulk count the final ply, since every generated move is legal
+    if (depth == 1) return size;
+
+    // Recurse on all legal moves
+    for (size -= 1; size >= 0; size--) {
+        applyMove(board, moves[size], undo);
+        found += perftHashed(board, depth-1, ptable);
+        revertMove(board, moves[size], undo);
+    }
+
+    storePerftEntry(ptable, board->hash, depth, found);
+
+    return found;
+}
+
+static void* perftWorker(void *vjob) {
+
+    int index;
+    Undo undo[1];
+    Board board;
+    PerftJob *job = (PerftJob*) vjob;
+
+    // Each worker searches on its own copy of the root position
+    memcpy(&board, job->board, sizeof(Board));
+
+    while (1) {
+
+        // Claim the next unsearched root move
+        pthread_mutex_lock(&job->lock);
+        index = job->next++;
+        pthread_mutex_unlock(&job->lock);
+
+        if (index >= job->size) break;
+
+        applyMove(&board, job->moves[index], undo);
+        job->counts[index] = perftHashed(&board, job->depth - 1, job->ptable);
+        revertMove(&board, job->moves[index], undo);
+    }
+
+    return NULL;
+}
+
+uint64_t perftRoot(Board *board, int depth, int nthreads, int divide) {
+
+    char moveStr[6];
+    double start, elapsed;
+    uint64_t nodes = 0ull;
+    PerftTable ptable;
+    PerftJob job;
+    pthread_t pthreads[nthreads];
+
+    if (depth <= 0) return 1ull;
+
+    start = getRealTime();
+
+    // Setup the root moves, which are shared out amongst the threads
+    job.board = board;
+    job.ptable = &ptable;
+    job.depth = depth;
+    job.next = job.size = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    genAllLegalMoves(board, job.moves, &job.size);
+    initPerftTable(&ptable, PERFT_HASH_MB);
+
+    for (int i = 1; i < nthreads; i++)
+        pthread_create(&pthreads[i], NULL, &perftWorker, &job);
+    perftWorker(&job);
+
+    for (int i = 1; i < nthreads; i++)
+        pthread_join(pthreads[i], NULL);
+
+    elapsed = getRealTime() - start;
+
+    // Report the node count of each root move for a perft divide
+    for (int i = 0; i < job.size; i++) {
+        nodes += job.counts[i];
+        if (!divide) continue;
+        moveToString(job.moves[i], moveStr);
+        printf("%s: %"PRIu64"\n", moveStr, job.counts[i]);
+    }
+
+    if (divide) {
+        printf("\nNodes : %"PRIu64"\n", nodes);
+        printf("Time  : %dms\n", (int)elapsed);
+        printf("NPS   : %d\n", (int)(nodes / (MAX(1.0, elapsed) / 1000.0)));
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    freePerftTable(&ptable);
+
+    return nodes;
+}
+
+static void* perftSuiteWorker(void *vsuite) {
+
+    int index;
+    Board board;
+    PerftSuite *suite = (PerftSuite*) vsuite;
+
+    while (1) {
+
+        // Claim the next untested position and depth
+        pthread_mutex_lock(&suite->lock);
+        index = suite->next++;
+        pthread_mutex_unlock(&suite->lock);
+
+        if (index >= suite->size) break;
+
+        boardFromFEN(&board, suite->tests[index].fen);
+        suite->tests[index].found = perftHashed(&board, suite->tests[index].depth, suite->ptable);
+    }
+
+    return NULL;
+}
+
+static int parsePerftSuite(const char *fname, PerftTest **tests) {
+
+    FILE *fin;
+    char line[1024], *fen, *token, *strPos = NULL;
+    int size = 0, capacity = 256, length;
+
+    if ((fin = fopen(fname, "r")) == NULL)
+        return -1;
+
+    *tests = malloc(sizeof(PerftTest) * capacity);
+
+    // Each line is of the form "<FEN> ;D1 <count> ;D2 <count> ..."
+    while (fgets(line, sizeof(line), fin) != NULL) {
+
+        if ((fen = strtok_r(line, ";", &strPos)) == NULL)
+            continue;
+
+        // Strip the whitespace which trails the FEN, and skip blank lines
+        for (length = strlen(fen); length && isspace(fen[length-1]); length--)
+            fen[length-1] = '\0';
+        if (!length) continue;
+
+        while ((token = strtok_r(NULL, ";", &strPos)) != NULL) {
+
+            if (size == capacity)
+                *tests = realloc(*tests, sizeof(PerftTest) * (capacity *= 2));
+
+            snprintf((*tests)[size].fen, sizeof((*tests)[size].fen), "%s", fen);
+            if (sscanf(token, " D%d %"SCNu64, &(*tests)[size].depth, &(*tests)[size].expected) == 2)
+                size++;
+        }
+    }
+
+    fclose(fin);
+    return size;
+}
+
+static int verifyQuietChecks(Board *board, int depth) {
+
+    Undo undo[1];
+    int size = 0, csize = 0, errors = 0, checks, found;
+    uint16_t moves[MAX_MOVES], quiets[MAX_MOVES];
+
+    genAllLegalMoves(board, moves, &size);
+
+    // Every legal quiet move, other than a castle, must be generated
+    // by genAllQuietChecks() exactly when it gives check
+    if (!board->kingAttackers) {
+
+        genAllQuietChecks(board, quiets, &csize);
+
+        for (int i = 0; i < size; i++) {
+
+            if (moveIsTactical(board, moves[i]) || MoveType(moves[i]) == CASTLE_MOVE)
+                continue;
+
+            applyMove(board, moves[i], undo);
+            checks = board->kingAttackers != 0ull;
+            revertMove(board, moves[i], undo);
+
+            for (found = 0; found < csize && quiets[found] != moves[i]; found++);
+            errors += checks != (found < csize);
+        }
+    }
+
+    if (depth <= 1) return errors;
+
+    for (int i = 0; i < size; i++) {
+        applyMove(board, moves[i], undo);
+        errors += verifyQuietChecks(board, depth-1);
+        revertMove(board, moves[i], undo);
+    }
+
+    return errors;
+}
+
+int runPerftSuite(const char *fname, int nthreads) {
+
+    int failed = 0, errors;
+    double start, elapsed;
+    uint64_t nodes = 0ull;
+    PerftTable ptable;
+    PerftSuite suite;
+    pthread_t pthreads[nthreads];
+
+    if ((suite.size = parsePerftSuite(fname, &suite.tests)) < 0) {
+        printf("Unable to open %s\n", fname);
+        return 1;
+    }
+
+    start = getRealTime();
+
+    // All threads share a single table. Entries are keyed by both the hash
+    // and the depth, so positions from every test may safely mix within it
+    suite.ptable = &ptable;
+    suite.next = 0;
+    pthread_mutex_init(&suite.lock, NULL);
+    initPerftTable(&ptable, PERFT_SUITE_HASH_MB);
+
+    for (int i = 1; i < nthreads; i++)
+        pthread_create(&pthreads[i], NULL, &perftSuiteWorker, &suite);
+    perftSuiteWorker(&suite);
+
+    for (int i = 1; i < nthreads; i++)
+        pthread_join(pthreads[i], NULL);
+
+    elapsed = getRealTime() - start;
+
+    // Report every mismatch before summarizing the entire suite
+    for (int i = 0; i < suite.size; i++) {
+
+        nodes += suite.tests[i].found;
+
+        // The quiet check generator is only used by qsearch(), so we verify
+        // it here by brute force, once for each position in the suite
+        if (i == 0 || strcmp(suite.tests[i].fen, suite.tests[i-1].fen)) {
+
+            Board board;
+            boardFromFEN(&board, suite.tests[i].fen);
+
+            if ((errors = verifyQuietChecks(&board, PERFT_CHECKS_DEPTH))) {
+                printf("FAILED %s ;quiet checks wrong at %d nodes\n", suite.tests[i].fen, errors);
+                failed++;
+            }
+        }
+
+        if (suite.tests[i].found != suite.tests[i].expected) {
+            printf("FAILED %s ;D%d expected %"PRIu64" found %"PRIu64"\n",
+                suite.tests[i].fen, suite.tests[i].depth,
+                suite.tests[i].expected, suite.tests[i].found);
+            failed++;
+        }
+    }
+
+    printf("Tests  : %d\n", suite.size);
+    printf("Failed : %d\n", failed);
+    printf("Nodes  : %"PRIu64"\n", nodes);
+    printf("Time   : %dms\n", (int)elapsed);
+    printf("NPS    : %d\n", (int)(nodes / (MAX(1.0, elapsed) / 1000.0)));
+
+    pthread_mutex_destroy(&suite.lock);
+    freePerftTable(&ptable);
+    free(suite.tests);
+
+    return failed != 0;
+}
@@ -0,0 +1,46 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "types.h"
+
+enum {
+    PERFT_HASH_MB = 16,
+    PERFT_SUITE_HASH_MB = 256,
+    PERFT_CHECKS_DEPTH = 3,
+};
+
+typedef struct PerftEntry {
+    uint64_t key;
+    uint64_t data;
+} PerftEntry;
+
+typedef struct PerftTable {
+    PerftEntry *entries;
+    uint64_t hashMask;
+} PerftTable;
+
+void initPerftTable(PerftTable *ptable, uint64_t megabytes);
+void freePerftTable(PerftTable *ptable);
+
+uint64_t perftHashed(Board *board, int depth, PerftTable *ptable);
+uint64_t perftRoot(Board *board, int depth, int nthreads, int divide);
+int runPerftSuite(const char *fname, int nthreads);
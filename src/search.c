@@ -53,6 +53,8 @@ volatile int ABORT_SIGNAL; // Global ABORT flag for threads
 
 volatile int IS_PONDERING; // Global PONDER flag for threads
 
+int QSearchChecks; // Search quiet checks and evasions in qsearch()
+
 
 void initSearch(){
 
@@ -62,24 +64,24 @@ void initSearch(){
             LMRTable[d][p] = 0.75 + log(d) * log(p) / 2.25;
 }
 
-void getBestMove(Thread* threads, Board* board, Limits* limits, uint16_t *best, uint16_t *ponder){
+void getBestMove(Thread* threads, Board* board, uint64_t* history, int length, Limits* limits, uint16_t *best, uint16_t *ponder){
 
     ABORT_SIGNAL = 0; // Clear the ABORT signal for the new search
 
     updateTT(); // Table is on a new search, thus a new generation
 
-    // Before searching, check to see if we are in the Syzygy Tablebases. If so
-    // the probe will return 1, will initialize the best move, and will report
-    // a depth MAX_PLY - 1 search to the interface. If found, we are done here.
-    if (tablebasesProbeDTZ(board, best)) { *ponder = NONE_MOVE; return; }
-
     // Initialize SearchInfo, used for reporting and time managment logic
     SearchInfo info;
     memset(&info, 0, sizeof(SearchInfo));
     initTimeManagment(&info, limits);
 
+    // Before searching, check to see if we are in the Syzygy Tablebases. If so
+    // every root move is ranked, and the search only considers those moves which
+    // preserve the best result. The search then still produces a PV and ponder move
+    info.rootMovesSize = tablebasesProbeRoot(board, info.rootMoves);
+
     // Setup the thread pool for a new search
-    newSearchThreadPool(threads, board, limits, &info);
+    newSearchThreadPool(threads, board, history, length, limits, &info);
 
     // Launch all of the threads
     pthread_t pthreads[threads[0].nthreads];
@@ -189,6 +191,19 @@ int aspirationWindow(Thread* thread, int depth, int lastValue){
     }
 }
 
+int rootMoveIsSearched(SearchInfo* info, uint16_t move){
+
+    // Without a restriction from the tablebases, we search every move
+    if (info->rootMovesSize == 0)
+        return 1;
+
+    for (int i = 0; i < info->rootMovesSize; i++)
+        if (info->rootMoves[i] == move)
+            return 1;
+
+    return 0;
+}
+
 int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int height){
 
     const int PvNode   = (alpha != beta - 1);
@@ -211,7 +226,7 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
     // Step 1. Quiescence Search. Perform a search using mostly tactical
     // moves to reach a more stable position for use as a static evaluation
     if (depth <= 0 && !board->kingAttackers)
-        return qsearch(thread, pv, alpha, beta, height);
+        return qsearch(thread, pv, alpha, beta, 0, height);
 
     // Ensure positive depth
     depth = MAX(0, depth);
@@ -231,12 +246,19 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
 
         // Check for the fifty move rule, a draw by
         // repetition, or insufficient mating material
-        if (boardIsDrawn(board, height))
+        if (boardIsDrawn(board, thread->hashStack, height))
             return 0;
 
+        // Check for an upcoming repetition. If one move can return us to a
+        // position already in the tree, then we can score at least a draw
+        if (alpha < 0 && upcomingRepetition(board, thread->hashStack, height)) {
+            alpha = oldAlpha = 0;
+            if (alpha >= beta) return alpha;
+        }
+
         // Check to see if we have exceeded the maxiumum search draft
         if (height >= MAX_PLY)
-            return evaluateBoard(board, &thread->pktable);
+            return evaluateBoard(board, &thread->pktable, &thread->mtable, NULL);
 
         // Mate Distance Pruning. Check to see if this line is so
         // good, or so bad, that being mated in the ply, or  mating in
@@ -266,7 +288,7 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
     // Step 5. Probe the Syzygy Tablebases. tablebasesProbeWDL() handles all of
     // the conditions about the board, the existance of tables, the probe depth,
     // as well as to not probe at the Root. The return is defined by the Fathom API
-    if ((tbresult = tablebasesProbeWDL(board, depth, height)) != TB_RESULT_FAILED){
+    if ((tbresult = tablebasesProbeWDL(thread, board, depth, height)) != TB_RESULT_FAILED){
 
         thread->tbhits++; // Increment tbhits counter for this thread
 
@@ -298,7 +320,7 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
 
     // Save off static evaluation history. Reuse TT entry eval if possible
     eval = thread->evalStack[height] = ttHit && ttEval != VALUE_NONE ? ttEval
-                                     : evaluateBoard(board, &thread->pktable);
+                                     : evaluateBoard(board, &thread->pktable, &thread->mtable, &thread->attackStack[height]);
 
     // Futility Pruning Margin
     futilityMargin = eval + FutilityMargin * depth;
@@ -321,7 +343,7 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
         && !inCheck
         &&  depth <= RazorDepth
         &&  eval + RazorMargin < alpha)
-        return qsearch(thread, pv, alpha, beta, height);
+        return qsearch(thread, pv, alpha, beta, 0, height);
 
     // Step 8. Beta Pruning / Reverse Futility Pruning / Static Null
     // Move Pruning. If the eval is few pawns above beta then exit early
@@ -370,7 +392,7 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
         while ((move = selectNextMove(&movePicker, board, 1)) != NONE_MOVE){
 
             // Move should pass an SEE() to be worth at least rBeta
-            if (!staticExchangeEvaluation(board, move, rBeta - eval))
+            if (!moveSEE(&movePicker, move, rBeta - eval))
                 continue;
 
             // Apply move, skip if move is illegal
@@ -397,6 +419,10 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
     initMovePicker(&movePicker, thread, ttMove, height);
     while ((move = selectNextMove(&movePicker, board, skipQuiets)) != NONE_MOVE){
 
+        // Skip any root moves which the tablebases have ruled out
+        if (RootNode && !rootMoveIsSearched(thread->info, move))
+            continue;
+
         // If this move is quiet we will save it to a list of attemped quiets.
         // Also lookup the history score, as we will in most cases need it.
         if ((isQuiet = !moveIsTactical(board, move))){
@@ -444,7 +470,7 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
             &&  best > MATED_IN_MAX
             &&  depth <= SEEPruningDepth
             &&  movePicker.stage > STAGE_GOOD_NOISY
-            && !staticExchangeEvaluation(board, move, seeMargin[isQuiet]))
+            && !moveSEE(&movePicker, move, seeMargin[isQuiet]))
             continue;
 
         // Apply move, skip if move is illegal
@@ -590,11 +616,11 @@ int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int h
     return best;
 }
 
-int qsearch(Thread* thread, PVariation* pv, int alpha, int beta, int height){
+int qsearch(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int height){
 
     Board* const board = &thread->board;
 
-    int eval, value, best, margin;
+    int eval, value, best, margin, evading;
     int ttHit, ttValue = 0, ttEval = 0, ttDepth = 0, ttBound = 0;
     uint16_t move, ttMove = NONE_MOVE;
 
@@ -615,16 +641,18 @@ int qsearch(Thread* thread, PVariation* pv, int alpha, int beta, int height){
 
     // Step 2. Draw Detection. Check for the fifty move rule,
     // a draw by repetition, or insufficient mating material
-    if (boardIsDrawn(board, height))
+    if (boardIsDrawn(board, thread->hashStack, height))
         return 0;
 
     // Step 3. Max Draft Cutoff. If we are at the maximum search draft,
     // then end the search here with a static eval of the current board
     if (height >= MAX_PLY)
-        return evaluateBoard(board, &thread->pktable);
+        return evaluateBoard(board, &thread->pktable, &thread->mtable, NULL);
 
-    // Step 4. Probe the Transposition Table, adjust the value, and consider cutoffs
-    if ((ttHit = getTTEntry(board->hash, &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound))){
+    // Step 4. Probe the Transposition Table, adjust the value, and consider cutoffs.
+    // The tuner (TRACE) resolves positions from many threads at once, and skips
+    // the probe so that each result is independent of the others and of the order
+    if ((ttHit = !TRACE && getTTEntry(board->hash, &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound))){
 
         ttValue = valueFromTT(ttValue, height); // Adjust any MATE scores
 
@@ -635,32 +663,47 @@ int qsearch(Thread* thread, PVariation* pv, int alpha, int beta, int height){
             return ttValue;
     }
 
+    // When searching quiet checks, we can't stand pat after one of them.
+    // Instead, we search every evasion, which also lets us find the mates
+    evading = QSearchChecks && board->kingAttackers;
+
     // Step 5. Eval Pruning. If a static evaluation of the board will
     // exceed beta, then we can stop the search here. Also, if the static
     // eval exceeds alpha, we can call our static eval the new alpha
-    best = eval = ttHit && ttEval != VALUE_NONE ? ttEval
-                : evaluateBoard(board, &thread->pktable);
-    alpha = MAX(alpha, eval);
-    if (alpha >= beta) return eval;
+    if (!evading) {
+        best = eval = ttHit && ttEval != VALUE_NONE ? ttEval
+                    : evaluateBoard(board, &thread->pktable, &thread->mtable, &thread->attackStack[height]);
+        alpha = MAX(alpha, eval);
+        if (alpha >= beta) return eval;
+    }
 
     // Step 6. Delta Pruning. Even the best possible capture and or promotion
     // combo with the additional boost of the futility margin would still fail
-    margin = alpha - eval - QFutilityMargin;
-    if (bestTacticalMoveValue(board) < margin)
+    margin = evading ? 0 : alpha - eval - QFutilityMargin;
+    if (!evading && bestTacticalMoveValue(board) < margin)
         return eval;
 
     // Step 7. Move Generation and Looping. Generate all tactical moves
     // and return those which are winning via SEE, and also strong enough
-    // the margin computed in the Delta Pruning step found above to beat
-    initNoisyMovePicker(&movePicker, thread, MAX(QSEEMargin, margin));
-    while ((move = selectNextMove(&movePicker, board, 1)) != NONE_MOVE) {
+    // the margin computed in the Delta Pruning step found above to beat.
+    // At the first ply, we may additionally try quiet checks passing SEE
+    if (!evading)
+        initNoisyMovePicker(&movePicker, thread, MAX(QSEEMargin, margin), height,
+                            QSearchChecks && depth == 0);
+
+    else {
+        best = -MATE + height;
+        initMovePicker(&movePicker, thread, NONE_MOVE, height);
+    }
+
+    while ((move = selectNextMove(&movePicker, board, !evading)) != NONE_MOVE) {
 
         // Apply move, skip if move is illegal
         if (!apply(thread, board, move, height))
             continue;
 
         // Search next depth
-        value = -qsearch(thread, &lpv, -beta, -alpha, height+1);
+        value = -qsearch(thread, &lpv, -beta, -alpha, depth-1, height+1);
 
         // Revert the board state
         revert(thread, board, move, height);
@@ -688,34 +731,23 @@ int qsearch(Thread* thread, PVariation* pv, int alpha, int beta, int height){
     return best;
 }
 
-int staticExchangeEvaluation(Board* board, uint16_t move, int threshold){
+int staticExchangeValue(Board* board, uint16_t move, AttackMaps* maps){
 
-    int from, to, type, ptype, colour, balance, nextVictim;
-    uint64_t bishops, rooks, occupied, attackers, myAttackers;
+    int from, to, type, colour, depth = 0, nextVictim, victimValue, gains[32];
+    uint64_t bishops, rooks, occupied, attackers, myAttackers, enemy, revealed;
 
     // Unpack move information
     from  = MoveFrom(move);
     to    = MoveTo(move);
     type  = MoveType(move);
-    ptype = MovePromoPiece(move);
-
-    // Next victim is moved piece, or promotion type when promoting
-    nextVictim = type != PROMOTION_MOVE
-               ? pieceType(board->squares[from])
-               : ptype;
 
-    // Balance is the value of the move minus threshold. Function
-    // call takes care for Enpass and Promotion moves. Castling is
-    // handled as a result of a King's value being zero, by trichotomy
-    // either the best case or the worst case condition will be hit
-    balance = thisTacticalMoveValue(board, move) - threshold;
+    // The moved piece, or the promotion piece, is the next to be captured
+    victimValue = type != PROMOTION_MOVE
+                ? SEEPieceValues[pieceType(board->squares[from])]
+                : SEEPieceValues[MovePromoPiece(move)];
 
-    // Best case is we lose nothing for the move
-    if (balance < 0) return 0;
-
-    // Worst case is losing the moved piece
-    balance -= SEEPieceValues[nextVictim];
-    if (balance >= 0) return 1;
+    // Initial gain is the value of the move itself
+    gains[0] = thisTacticalMoveValue(board, move);
 
     // Grab sliders for updating revealed attackers
     bishops = board->pieces[BISHOP] | board->pieces[QUEEN];
@@ -726,6 +758,27 @@ int staticExchangeEvaluation(Board* board, uint16_t move, int threshold){
     occupied = (occupied ^ (1ull << from)) | (1ull << to);
     if (type == ENPASS_MOVE) occupied ^= (1ull << board->epSquare);
 
+    // The evaluation's attack maps, if they were computed for this position,
+    // hold every square our opponent attacks. If the target square is not one
+    // of them, only a slider revealed behind the moving piece could recapture.
+    // When nothing can recapture, the exchange is worth just the move itself
+    if (    maps != NULL
+        &&  maps->hash == board->hash
+        &&  type != ENPASS_MOVE
+        && !testBit(maps->attacked[!board->turn], to)) {
+
+        enemy = board->colours[!board->turn];
+        revealed = 0ull;
+
+        if (abs(fileOf(from) - fileOf(to)) == abs(rankOf(from) - rankOf(to)))
+            revealed |= bishopAttacks(to, occupied) & bishops & enemy;
+
+        if (fileOf(from) == fileOf(to) || rankOf(from) == rankOf(to))
+            revealed |= rookAttacks(to, occupied) & rooks & enemy;
+
+        if (!revealed) return gains[0];
+    }
+
     // Get all pieces which attack the target square. And with occupied
     // so that we do not let the same piece attack twice
     attackers = allAttackersToSquare(board, occupied, to) & occupied;
@@ -735,7 +788,7 @@ int staticExchangeEvaluation(Board* board, uint16_t move, int threshold){
 
     while (1){
 
-        // If we have no more attackers left we lose
+        // If we have no more attackers left the exchange is over
         myAttackers = attackers & board->colours[colour];
         if (myAttackers == 0ull) break;
 
@@ -744,6 +797,15 @@ int staticExchangeEvaluation(Board* board, uint16_t move, int threshold){
             if (myAttackers & board->pieces[nextVictim])
                 break;
 
+        // The King may only recapture when no attackers would remain
+        if (nextVictim == KING && (attackers & board->colours[!colour]))
+            break;
+
+        // Speculatively store the gain of this capture, were it to be made
+        depth += 1;
+        gains[depth] = victimValue - gains[depth-1];
+        victimValue = SEEPieceValues[nextVictim];
+
         // Remove this attacker from the occupied
         occupied ^= (1ull << getlsb(myAttackers & board->pieces[nextVictim]));
 
@@ -760,25 +822,15 @@ int staticExchangeEvaluation(Board* board, uint16_t move, int threshold){
 
         // Swap the turn
         colour = !colour;
+    }
 
-        // Negamax the balance and add the value of the next victim
-        balance = -balance - 1 - SEEPieceValues[nextVictim];
-
-        // If the balance is non negative after giving away our piece then we win
-        if (balance >= 0){
-
-            // As a slide speed up for move legality checking, if our last attacking
-            // piece is a king, and our opponent still has attackers, then we've
-            // lost as the move we followed would be illegal
-            if (nextVictim == KING && (attackers & board->colours[colour]))
-                colour = !colour;
-
-            break;
-        }
+    // Negamax the gains, as either side may decline to continue capturing
+    while (depth > 0) {
+        gains[depth-1] = -MAX(-gains[depth-1], gains[depth]);
+        depth -= 1;
     }
 
-    // Side to move after the loop loses
-    return board->turn != colour;
+    return gains[0];
 }
 
 int moveIsTactical(Board* board, uint16_t move){
@@ -33,6 +33,8 @@ struct SearchInfo {
     double maxAlloc;
     double maxUsage;
     int pvFactor;
+    int rootMovesSize;
+    uint16_t rootMoves[MAX_MOVES];
 };
 
 struct PVariation {
@@ -43,17 +45,19 @@ struct PVariation {
 
 void initSearch();
 
-void getBestMove(Thread* threads, Board* board, Limits* limits, uint16_t *best, uint16_t *ponder);
+void getBestMove(Thread* threads, Board* board, uint64_t* history, int length, Limits* limits, uint16_t *best, uint16_t *ponder);
 
 void* iterativeDeepening(void* vthread);
 
 int aspirationWindow(Thread* thread, int depth, int lastValue);
 
+int rootMoveIsSearched(SearchInfo* info, uint16_t move);
+
 int search(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int height);
 
-int qsearch(Thread* thread, PVariation* pv, int alpha, int beta, int height);
+int qsearch(Thread* thread, PVariation* pv, int alpha, int beta, int depth, int height);
 
-int staticExchangeEvaluation(Board* board, uint16_t move, int threshold);
+int staticExchangeValue(Board* board, uint16_t move, AttackMaps* maps);
 
 int moveIsTactical(Board* board, uint16_t move);
 
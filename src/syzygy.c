@@ -17,24 +17,111 @@
 */
 
 #include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "bitboards.h"
 #include "board.h"
 #include "fathom/tbprobe.h"
 #include "move.h"
 #include "movegen.h"
+#include "syzygy.h"
+#include "thread.h"
+#include "time.h"
 #include "types.h"
 #include "uci.h"
+#include "zobrist.h"
 
 
 unsigned TB_PROBE_DEPTH; // Set by UCI options
 
+unsigned TB_PRELOAD_PIECES; // Set by UCI options
+
 extern unsigned TB_LARGEST; // Set by Fathom in tb_init()
 
+uint64_t TBCache[TB_CACHE_SIZE]; // Shared by all Threads, without locks
+
+
+static pthread_t TBPreloadThread; // Background Thread mapping the tables
+
+static int TBPreloadRunning; // Set while TBPreloadThread must be joined
+
+
+void clearTablebaseCache(){
+    memset(TBCache, 0, sizeof(TBCache));
+}
+
+static void* tablebasesPreloadThread(void* vargs){
+
+    (void) vargs;
+
+    double start = getRealTime();
+    uint64_t bytes, totalBytes = 0ull;
+    unsigned count, totalCount = 0;
+
+    // Smaller tables are probed far more often, so we map those first,
+    // and report our progress to the interface after each piece count
+    for (unsigned pieces = 3; pieces <= TB_PRELOAD_PIECES && pieces <= TB_LARGEST; pieces++){
+
+        count = tb_preload(pieces, &bytes);
+        totalCount += count; totalBytes += bytes;
+
+        printf("info string syzygy preloaded %u %u-man tables (%"PRIu64"MB)\n",
+               count, pieces, bytes >> 20);
+        fflush(stdout);
+    }
+
+    printf("info string syzygy preload finished, %u tables (%"PRIu64"MB) in %dms\n",
+           totalCount, totalBytes >> 20, (int)(getRealTime() - start));
+    fflush(stdout);
+
+    return NULL;
+}
+
+void tablebasesWaitForPreload(){
+
+    // The tables must not be remapped by tb_init() while a preload is
+    // walking them, nor should two preloads ever run at the same time
+    if (TBPreloadRunning)
+        pthread_join(TBPreloadThread, NULL);
+
+    TBPreloadRunning = 0;
+}
+
+void tablebasesPreload(){
+
+    tablebasesWaitForPreload();
+
+    // Only preload when requested, and when there are tables to map
+    if (TB_PRELOAD_PIECES >= 3 && TB_LARGEST >= 3){
+        pthread_create(&TBPreloadThread, NULL, &tablebasesPreloadThread, NULL);
+        TBPreloadRunning = 1;
+    }
+}
+
+static unsigned fathomProbeWDL(Board* board){
+
+    return tb_probe_wdl(
+        board->colours[WHITE],
+        board->colours[BLACK],
+        board->pieces[KING  ],
+        board->pieces[QUEEN ],
+        board->pieces[ROOK  ],
+        board->pieces[BISHOP],
+        board->pieces[KNIGHT],
+        board->pieces[PAWN  ],
+        board->fiftyMoveRule,
+        board->castleRights,
+        board->epSquare == -1 ? 0 : board->epSquare,
+        board->turn == WHITE ? 1 : 0
+    );
+}
 
-unsigned tablebasesProbeWDL(Board* board, int depth, int height){
+unsigned tablebasesProbeWDL(Thread* thread, Board* board, int depth, int height){
 
     // Tap into Fathom's API routines. Fathom checks for empty
     // castling rights and no enpassant square, so unlike Stockfish
@@ -66,33 +153,69 @@ unsigned tablebasesProbeWDL(Board* board, int depth, int height){
         || (cardinality == (int)TB_LARGEST && depth < (int)TB_PROBE_DEPTH))
         return TB_RESULT_FAILED;
 
-    return tb_probe_wdl(
-        board->colours[WHITE],
-        board->colours[BLACK],
-        board->pieces[KING  ],
-        board->pieces[QUEEN ],
-        board->pieces[ROOK  ],
-        board->pieces[BISHOP],
-        board->pieces[KNIGHT],
-        board->pieces[PAWN  ],
-        board->fiftyMoveRule,
-        board->castleRights,
-        board->epSquare == -1 ? 0 : board->epSquare,
-        board->turn == WHITE ? 1 : 0
-    );
+    // Each entry is a single word, holding the upper bits of the hash and a
+    // code for the result, so a torn read between Threads is not possible.
+    // Codes are the WDL result plus one, or TB_CACHE_FAILED, leaving zero
+    // to mark an empty entry. Failed probes are cached just like results
+    uint64_t *entry = &TBCache[board->hash & (TB_CACHE_SIZE - 1)];
+    uint64_t cached = *entry;
+
+    if (cached && (cached & ~TB_CACHE_MASK) == (board->hash & ~TB_CACHE_MASK)) {
+        thread->tbcacheHits++;
+        return (cached & TB_CACHE_MASK) == TB_CACHE_FAILED
+             ? TB_RESULT_FAILED : (unsigned)(cached & TB_CACHE_MASK) - 1;
+    }
+
+    thread->tbcacheMisses++;
+
+    unsigned result = fathomProbeWDL(board);
+
+    *entry = (board->hash & ~TB_CACHE_MASK)
+           | (result == TB_RESULT_FAILED ? TB_CACHE_FAILED : result + 1);
+
+    return result;
 }
 
-int tablebasesProbeDTZ(Board* board, uint16_t* move){
+static uint16_t convertFathomMove(Board* board, unsigned result){
+
+    unsigned to    = TB_GET_TO(result);
+    unsigned from  = TB_GET_FROM(result);
+    unsigned ep    = TB_GET_EP(result);
+    unsigned promo = TB_GET_PROMOTES(result);
 
-    int i, size = 0;
+    // Normal Moves ( Syzygy does not support castling )
+    if (ep == 0u && promo == 0u)
+        return MoveMake(from, to, NORMAL_MOVE);
+
+    // Enpass Moves. Fathom returns a to square, but in Ethereal board->epSquare
+    // is not the square of the captured pawn, but the square that the capturing
+    // pawn will be moving to. Thus, we ignore Fathom's to value to be safe
+    if (ep != 0u)
+        return MoveMake(from, board->epSquare, ENPASS_MOVE);
+
+    // Promotion Moves. Fathom has the inverted order of our promotion
+    // flags. Thus, four minus the flag converts to our representation.
+    // Also, we shift by 14 to actually match the flags we use in Ethereal
+    return MoveMake(from, to, PROMOTION_MOVE | ((4 - promo) << 14));
+}
+
+static int wdlClass(unsigned wdl){
+
+    // Blessed losses and cursed wins are draws under the fifty move rule
+    return wdl == TB_WIN ? 2 : wdl == TB_LOSS ? 0 : 1;
+}
+
+int tablebasesProbeRoot(Board* board, uint16_t* rootMoves){
+
+    int i, j, size = 0, count = 0, found;
     uint16_t moves[MAX_MOVES];
-    unsigned wdl, dtz, to, from, ep, promo;
+    unsigned results[TB_MAX_MOVES], best = TB_LOSS;
 
     // Check to make sure we expect to be within the Syzygy tables
     if (popcount(board->colours[WHITE] | board->colours[BLACK]) > (int)TB_LARGEST)
         return 0;
 
-    // Tap into Fathom's API routines
+    // Tap into Fathom's API routines, which rank every legal move
     unsigned result = tb_probe_root(
         board->colours[WHITE],
         board->colours[BLACK],
@@ -106,7 +229,7 @@ int tablebasesProbeDTZ(Board* board, uint16_t* move){
         board->castleRights,
         board->epSquare == -1 ? 0 : board->epSquare,
         board->turn == WHITE ? 1 : 0,
-        NULL
+        results
     );
 
     // Probe failed, or we are already in a finished position, in which
@@ -117,47 +240,151 @@ int tablebasesProbeDTZ(Board* board, uint16_t* move){
         || result == TB_RESULT_STALEMATE)
         return 0;
 
-    // Extract Fathom's score representations
-    wdl = TB_GET_WDL(result);
-    dtz = TB_GET_DTZ(result);
+    // Fathom's WDL for each move already accounts for the fifty move
+    // rule, so any move which keeps the best WDL still makes progress
+    for (i = 0; results[i] != TB_RESULT_FAILED; i++)
+        if (wdlClass(TB_GET_WDL(results[i])) > wdlClass(best))
+            best = TB_GET_WDL(results[i]);
 
-    // Extract Fathom's move representation
-    to    = TB_GET_TO(result);
-    from  = TB_GET_FROM(result);
-    ep    = TB_GET_EP(result);
-    promo = TB_GET_PROMOTES(result);
+    // Keep every move which preserves the best result, verifying the
+    // legality of each parsed move as a final safety check
+    genAllLegalMoves(board, moves, &size);
+    for (i = 0; results[i] != TB_RESULT_FAILED; i++){
 
-    // Normal Moves ( Syzygy does not support castling )
-    if (ep == 0u && promo == 0u)
-        *move = MoveMake(from, to, NORMAL_MOVE);
+        if (wdlClass(TB_GET_WDL(results[i])) != wdlClass(best))
+            continue;
 
-    // Enpass Moves. Fathom returns a to square, but in Ethereal board->epSquare
-    // is not the square of the captured pawn, but the square that the capturing
-    // pawn will be moving to. Thus, we ignore Fathom's to value to be safe
-    else if (ep != 0u)
-        *move = MoveMake(from, board->epSquare, ENPASS_MOVE);
+        uint16_t move = convertFathomMove(board, results[i]);
 
-    // Promotion Moves. Fathom has the inverted order of our promotion
-    // flags. Thus, four minus the flag converts to our representation.
-    // Also, we shift by 14 to actually match the flags we use in Ethereal
-    else if (promo != 0u)
-        *move = MoveMake(from, to, PROMOTION_MOVE | ((4 - promo) << 14));
+        for (found = 0, j = 0; j < size; j++)
+            found |= moves[j] == move;
 
-    // Unable to read back the move type. Setting the move to NONE_MOVE
-    // ensures that we will not illegally return the move to the interface
-    else
-        *move = NONE_MOVE, assert(0);
+        assert(found);
+        if (found) rootMoves[count++] = move;
+    }
 
-    // Verify the legality of the parsed move as a final safety check
-    genAllLegalMoves(board, moves, &size);
-    for (i = 0; i < size; i++){
-        if (moves[i] == *move){
-            uciReportTBRoot(*move, wdl, dtz);
-            return 1;
+    uciReportTBRoot(best, count, size);
+
+    return count;
+}
+
+static void randomTablebasePosition(Board* board){
+
+    static const char pieces[] = "PNBRQpnbrq";
+
+    char fen[128], squares[SQUARE_NB], *ptr;
+    int count = 2 + rand64() % (TB_LARGEST - 1);
+
+    // Place both Kings and up to TB_LARGEST pieces onto random squares,
+    // without any pawns on the back ranks, and retry until the side which
+    // is not to move is not left in check, so that the position is legal
+    while (1){
+
+        memset(squares, 0, sizeof(squares));
+
+        for (int i = 0; i < count; i++){
+
+            int sq, piece = i == 0 ? 'K' : i == 1 ? 'k' : pieces[rand64() % 10];
+
+            do sq = rand64() % SQUARE_NB;
+            while (squares[sq] || ((piece == 'P' || piece == 'p') && (sq < 8 || sq >= 56)));
+
+            squares[sq] = piece;
+        }
+
+        ptr = fen;
+        for (int rank = RANK_NB - 1; rank >= 0; rank--){
+            for (int file = 0, empty = 0; file < FILE_NB; file++){
+                int piece = squares[square(rank, file)];
+                if (piece && empty) *ptr++ = '0' + empty, empty = 0;
+                if (piece) *ptr++ = piece; else empty++;
+                if (file == FILE_NB - 1 && empty) *ptr++ = '0' + empty;
+            }
+            *ptr++ = rank ? '/' : ' ';
         }
+
+        sprintf(ptr, "%c - - 0 1", rand64() % 2 ? 'w' : 'b');
+        boardFromFEN(board, fen);
+
+        int king = getlsb(board->colours[!board->turn] & board->pieces[KING]);
+        if (!squareIsAttacked(board, !board->turn, king))
+            return;
+    }
+}
+
+static void* tablebasesStressWorker(void* vargs){
+
+    TBStress* stress = (TBStress*) vargs;
+    int index = __atomic_fetch_add(&stress->next, 1, __ATOMIC_RELAXED);
+
+    // Every Thread probes the same positions in the same order, so that
+    // they all race to load the same tables at the same moments
+    for (int i = 0; i < stress->size; i++)
+        stress->results[index * stress->size + i] = fathomProbeWDL(&stress->boards[i]);
+
+    return NULL;
+}
+
+int runTablebaseStress(const char* path, int nthreads){
+
+    // This thread is always one of the workers, and needs its own results
+    if (nthreads < 1){
+        printf("Usage: ./Ethereal tbstress <path> <threads>, with at least one thread\n");
+        return 1;
     }
 
-    // Something went wrong, but as long as we pretend
-    // we failed to probe then nothing is going to break
-    assert(0); return 0;
+    TBStress stress;
+    pthread_t pthreads[nthreads];
+    int failed = 0, mismatched = 0;
+    double start, elapsed;
+
+    tb_init(path);
+
+    if (TB_LARGEST < 3){
+        printf("No tablebases found in %s\n", path);
+        return 1;
+    }
+
+    stress.size    = TB_STRESS_POSITIONS;
+    stress.next    = 0;
+    stress.boards  = malloc(sizeof(Board) * stress.size);
+    stress.results = malloc(sizeof(unsigned) * stress.size * nthreads);
+
+    for (int i = 0; i < stress.size; i++)
+        randomTablebasePosition(&stress.boards[i]);
+
+    // Tables are loaded lazily, so every Thread starts with none of them
+    start = getRealTime();
+
+    for (int i = 1; i < nthreads; i++)
+        pthread_create(&pthreads[i], NULL, &tablebasesStressWorker, &stress);
+    tablebasesStressWorker(&stress);
+
+    for (int i = 1; i < nthreads; i++)
+        pthread_join(pthreads[i], NULL);
+
+    elapsed = getRealTime() - start;
+
+    // Each position must have the same result from every Thread, and
+    // from one more probe made after every table has been loaded
+    for (int i = 0; i < stress.size; i++){
+
+        unsigned expected = fathomProbeWDL(&stress.boards[i]);
+        failed += expected == TB_RESULT_FAILED;
+
+        for (int j = 0; j < nthreads; j++)
+            mismatched += stress.results[j * stress.size + i] != expected;
+    }
+
+    printf("Threads    : %d\n", nthreads);
+    printf("Probes     : %d\n", stress.size * nthreads);
+    printf("Failed     : %d\n", failed);
+    printf("Mismatched : %d\n", mismatched);
+    printf("Time       : %dms\n", (int)elapsed);
+    printf("PPS        : %d\n", (int)(stress.size * nthreads / (MAX(1.0, elapsed) / 1000.0)));
+
+    free(stress.boards);
+    free(stress.results);
+
+    return mismatched != 0;
 }
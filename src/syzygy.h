@@ -19,10 +19,32 @@
 #ifndef _SYZYGY_H
 #define _SYZYGY_H
 
+#include <stdint.h>
+
 #include "types.h"
 
-int tablebasesProbeDTZ(Board* board, uint16_t* move);
+#define TB_CACHE_SIZE   (1 << 16) // Entries in the WDL cache, a power of two
+#define TB_CACHE_MASK   (0x7ull)  // Low bits of an entry hold the result code
+#define TB_CACHE_FAILED (0x7ull)  // Result code for a failed probe
+
+#define TB_STRESS_POSITIONS (100000) // Positions probed by each Thread
+
+typedef struct TBStress {
+    int size, next;
+    Board* boards;
+    unsigned* results;
+} TBStress;
+
+void clearTablebaseCache();
+
+void tablebasesWaitForPreload();
+
+void tablebasesPreload();
+
+int tablebasesProbeRoot(Board* board, uint16_t* rootMoves);
+
+unsigned tablebasesProbeWDL(Thread* thread, Board* board, int depth, int height);
 
-unsigned tablebasesProbeWDL(Board* board, int depth, int height);
+int runTablebaseStress(const char* path, int nthreads);
 
 #endif
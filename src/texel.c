@@ -18,10 +18,16 @@
 
 #ifdef TUNE
 
+#include <fcntl.h>
+#include <inttypes.h>
 #include <math.h>
+#include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "bitboards.h"
 #include "board.h"
@@ -37,12 +43,14 @@
 #include "uci.h"
 #include "zobrist.h"
 
-// Internal Memory Managment
-TexelTuple* TupleStack;
-int TupleStackSize = STACKSIZE;
+// Tuner configuration, set from the command line by runTexelTuning()
+int TexelPositions;       // Positions in use, or zero for the entire dataset
+int TexelBatchSize;       // Positions per mini-batch
+int TexelEpochs;          // Epochs to run, or zero to run until stopped
+int TexelOptimizer;       // One of TEXEL_SGD, TEXEL_ADAGRAD, or TEXEL_ADAM
+double TexelLearningRate; // Initial learning rate
 
 // Tap into evaluate()
-extern EvalTrace T, EmptyTrace;
 
 extern const int PawnValue;
 extern const int KnightValue;
@@ -89,12 +97,25 @@ extern const int ThreatQueenAttackedByOne;
 extern const int ThreatOverloadedPieces;
 extern const int ThreatByPawnPush;
 
-void runTexelTuning(Thread *thread) {
+void runTexelTuning(int argc, char **argv) {
 
     TexelEntry *tes;
-    int iteration = -1;
-    double K, error, best = 1e6, rate = LEARNING;
-    TexelVector params = {0}, cparams = {0};
+    TexelDataset data;
+    TexelState *state = calloc(1, sizeof(TexelState));
+    TexelVector cparams = {0};
+    double error;
+
+    // Optional arguments: positions, batch size, learning rate, epochs, and optimizer
+    TexelPositions    = argc > 0 ? atoi(argv[0]) : 0;
+    TexelBatchSize    = argc > 1 ? atoi(argv[1]) : BATCHSIZE;
+    TexelLearningRate = argc > 2 ? atof(argv[2]) : LEARNING;
+    TexelEpochs       = argc > 3 ? atoi(argv[3]) : 0;
+    TexelOptimizer    = argc > 4 ? parseTexelOptimizer(argv[4]) : TEXEL_SGD;
+
+    if (TexelPositions < 0 || TexelBatchSize <= 0 || TexelEpochs < 0 || TexelOptimizer < 0) {
+        printf("Usage: ./Ethereal tune [positions] [batchsize] [learningrate] [epochs] [sgd|adagrad|adam]\n");
+        exit(EXIT_FAILURE);
+    }
 
     setvbuf(stdout, NULL, _IONBF, 0);
 
@@ -103,128 +124,482 @@ void runTexelTuning(Thread *thread) {
     printf("\n\nSetting Table size to 1MB for speed...");
     initTT(1);
 
-    printf("\n\nAllocating Memory for Texel Entries [%dKB]...",
-           (int)(NPOSITIONS * sizeof(TexelEntry) / 1024));
-    tes = calloc(NPOSITIONS, sizeof(TexelEntry));
+    // Prefer the resolved binary dataset, created with ./Ethereal texelbinary
+    if (loadTexelBinary(&data))
+        printf("\n\nMapped Texel Entries from %s...", TEXELBINARY);
+
+    else {
+        printf("\n\nInitializing Texel Entries from FENS...");
+        initTexelDataset(&data);
+    }
 
-    printf("\n\nAllocating Memory for Texel Tuple Stack [%dKB]...",
-           (int)(STACKSIZE * sizeof(TexelTuple) / 1024));
-    TupleStack = calloc(STACKSIZE, sizeof(TexelTuple));
+    // Use no more positions than the dataset actually has
+    TexelPositions = data.npositions;
+    if (TexelPositions < TexelBatchSize) {
+        printf("\n\nDataset of %d positions is smaller than a batch\n", TexelPositions);
+        exit(EXIT_FAILURE);
+    }
 
-    printf("\n\nInitializing Texel Entries from FENS...");
-    initTexelEntries(tes, thread);
+    printf("\n\nUsing %d Positions with %"PRIu64" Tuples [%dKB]...",
+           TexelPositions, data.ntuples, (int)(data.ntuples * sizeof(TexelTuple) / 1024));
+
+    printf("\n\nAllocating Memory for Texel Entries [%dKB]...",
+           (int)(TexelPositions * sizeof(TexelEntry) / 1024));
+    tes = calloc(TexelPositions, sizeof(TexelEntry));
+    initTexelEntries(tes, &data);
 
     printf("\n\nFetching Current Evaluation Terms as a Starting Point...");
     initCurrentParameters(cparams);
+    initTexelState(state, &data, cparams);
+
+    // Continue from where a previous run left off, skipping the K search.
+    // The saved learning rate has been dropped on any regression, and so
+    // replaces the one given, which is only used for a fresh start
+    if (loadTexelCheckpoint(state)) {
+        printf("\n\nResuming from %s at Iteration [%d] K = %f...", CHECKPOINT, state->iteration, state->K);
+        printf("\n\nUsing the saved Learning Rate of %g%s...\n", state->rate,
+               argc > 2 && state->rate != TexelLearningRate ? ", not the one given" : "");
+    }
 
-    printf("\n\nComputing Optimal K Value...\n");
-    K = computeOptimalK(tes);
+    else {
+        printf("\n\nComputing Optimal K Value...\n");
+        state->K    = computeOptimalK(tes);
+        state->rate = TexelLearningRate;
+        state->best = 1e6;
+    }
 
-    while (1) {
+    for (; !TexelEpochs || state->iteration < TexelEpochs; state->iteration++) {
 
         // Shuffle the dataset before each epoch
         shuffleTexelEntries(tes);
 
         // Report every REPORTING iterations
-        if (++iteration % REPORTING == 0) {
+        if (state->iteration % REPORTING == 0) {
 
             // Check for a regression in tuning
-            error = completeLinearError(tes, params, K);
-            if (error > best) rate = rate / LRDROPRATE;
+            error = completeLinearError(tes, state->params, state->K);
+            if (error > state->best) state->rate = state->rate / LRDROPRATE;
+
+            // Report current best parameters, and save our progress
+            state->best = error;
+            printParameters(state->params, cparams);
+            printf("\nIteration [%d] Error = %g \n", state->iteration, state->best);
+            saveTexelCheckpoint(state);
+        }
 
-            // Report current best parameters
-            best = error;
-            printParameters(params, cparams);
-            printf("\nIteration [%d] Error = %g \n", iteration, best);
+        for (int batch = 0; batch < TexelPositions / TexelBatchSize; batch++) {
+            TexelVector gradient = {0};
+            updateGradient(tes, gradient, state->params, state->K, batch);
+            updateParameters(state, gradient);
         }
+    }
 
-        for (int batch = 0; batch < NPOSITIONS / BATCHSIZE; batch++) {
+    // Report the final parameters once all epochs are complete
+    printParameters(state->params, cparams);
+    printf("\nIteration [%d] Error = %g \n", state->iteration, completeLinearError(tes, state->params, state->K));
+    saveTexelCheckpoint(state);
 
-            TexelVector gradient = {0};
-            updateGradient(tes, gradient, params, K, batch);
+    free(tes);
+    free(state);
+    freeTexelDataset(&data);
+}
+
+int parseTexelOptimizer(char *name) {
+    return stringEquals(name, "sgd"    ) ? TEXEL_SGD
+         : stringEquals(name, "adagrad") ? TEXEL_ADAGRAD
+         : stringEquals(name, "adam"   ) ? TEXEL_ADAM : -1;
+}
+
+void updateParameters(TexelState *state, TexelVector gradient) {
 
-            // Update Parameters. Note that in updateGradient() we skip the multiplcation by negative
-            // two over BATCHSIZE. This is done only here, just once, for precision and a speed gain
-            for (int i = 0; i < NTERMS; i++)
-                for (int j = MG; j <= EG; j++)
-                    params[i][j] += (2.0 / BATCHSIZE) * rate * gradient[i][j];
+    // Note that in updateGradient() we skip the multiplcation by negative two
+    // over the batch size. This is done only here, just once, for precision
+    // and a speed gain. The result is the direction of steepest descent
+    const double scale = 2.0 / TexelBatchSize;
+    const double rate  = state->rate;
+
+    state->step++;
+
+    // Adam's bias corrections for moments which started at zero
+    const double correct1 = 1.0 - pow(ADAMBETA1, state->step);
+    const double correct2 = 1.0 - pow(ADAMBETA2, state->step);
+
+    for (int i = 0; i < NTERMS; i++) {
+        for (int j = MG; j <= EG; j++) {
+
+            double g = scale * gradient[i][j];
+
+            if (TexelOptimizer == TEXEL_SGD)
+                state->params[i][j] += rate * g;
+
+            // AdaGrad scales each term by the history of its gradients
+            else if (TexelOptimizer == TEXEL_ADAGRAD) {
+                state->velocity[i][j] += g * g;
+                state->params[i][j]   += rate * g / (sqrt(state->velocity[i][j]) + EPSILON);
+            }
+
+            // Adam uses decaying averages of the gradient and its square
+            else if (TexelOptimizer == TEXEL_ADAM) {
+                state->moment[i][j]   = ADAMBETA1 * state->moment[i][j]   + (1 - ADAMBETA1) * g;
+                state->velocity[i][j] = ADAMBETA2 * state->velocity[i][j] + (1 - ADAMBETA2) * g * g;
+                state->params[i][j]  += rate * (state->moment[i][j] / correct1)
+                                      / (sqrt(state->velocity[i][j] / correct2) + EPSILON);
+            }
         }
     }
 }
 
-void initTexelEntries(TexelEntry *tes, Thread *thread) {
+void initTexelState(TexelState *state, TexelDataset *data, TexelVector cparams) {
+
+    // Identify what the params are relative to, so that a checkpoint is
+    // never applied to different terms, data, or batching than its own
+    memcpy(state->magic, TUNERMAGIC, sizeof(state->magic));
+    state->nterms     = NTERMS;
+    state->optimizer  = TexelOptimizer;
+    state->checksum   = checksumParameters(cparams);
+    state->npositions = data->npositions;
+    state->ntuples    = data->ntuples;
+    state->batchsize  = TexelBatchSize;
+}
 
-    Undo undo[1];
-    Limits limits;
-    char line[128];
-    int i, j, k, coeffs[NTERMS];
-    FILE *fin = fopen("FENS", "r");
+void saveTexelCheckpoint(TexelState *state) {
+
+    char temp[64];
+    FILE *fout;
+
+    // Write to a temporary file first, so an interrupted save never
+    // leaves behind a corrupt checkpoint in place of a good one
+    sprintf(temp, "%s.tmp", CHECKPOINT);
+
+    if (   (fout = fopen(temp, "wb")) == NULL
+        || fwrite(state, sizeof(TexelState), 1, fout) != 1
+        || fclose(fout) != 0
+        || rename(temp, CHECKPOINT) != 0)
+        printf("Unable to save %s\n", CHECKPOINT);
+}
+
+int loadTexelCheckpoint(TexelState *state) {
+
+    TexelState *saved;
+    FILE *fin = fopen(CHECKPOINT, "rb");
+    if (fin == NULL) return 0;
+
+    // Only resume if the checkpoint has the identity set by initTexelState()
+    saved = malloc(sizeof(TexelState));
+
+    if (   fread(saved, sizeof(TexelState), 1, fin) != 1
+        || memcmp(saved->magic, state->magic, sizeof(saved->magic))
+        || saved->nterms     != state->nterms
+        || saved->optimizer  != state->optimizer
+        || saved->checksum   != state->checksum
+        || saved->npositions != state->npositions
+        || saved->ntuples    != state->ntuples
+        || saved->batchsize  != state->batchsize) {
+        printf("\n\n%s does not match these terms, dataset, batch size or optimizer,"
+               " remove it to start over\n", CHECKPOINT);
+        fclose(fin);
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(state, saved, sizeof(TexelState));
+    fclose(fin);
+    free(saved);
+    return 1;
+}
+
+Thread* createTexelThreads(Limits *limits) {
+
+    // One Thread for each OpenMP thread, each with its own Pawn King Table
+    Thread *threads = createThreadPool(omp_get_max_threads());
+
+    // Initialize the threads for the quiescence searches
+    for (int i = 0; i < threads[0].nthreads; i++)
+        threads[i].limits = limits, threads[i].depth = 0;
+
+    return threads;
+}
+
+int resolveTexelBlock(FILE *fin, Thread *threads, TexelBinaryEntry *entries, TexelTuple *tuples, int max) {
+
+    int count = 0;
+    char (*lines)[128] = malloc(max * sizeof(*lines));
+
+    while (count < max && fgets(lines[count], 128, fin) != NULL)
+        count++;
+
+    // Each position has room for NTERMS Tuples, which the caller compacts
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < count; i++) {
+        int coeffs[NTERMS];
+        resolveTexelPosition(&threads[omp_get_thread_num()], lines[i], &entries[i], coeffs);
+        initTexelTuples(&tuples[i * NTERMS], coeffs);
+    }
+
+    free(lines);
+    return count;
+}
+
+void initTexelDataset(TexelDataset *data) {
+
+    int count, limit, entryCapacity = 0;
+    Limits limits = {0};
+    uint64_t capacity = 0;
+
+    FILE *fin = fopen(TEXELFENS, "r");
+    TexelBinaryEntry *entries = malloc(READBATCH * sizeof(TexelBinaryEntry));
+    TexelTuple *tuples = malloc(READBATCH * NTERMS * sizeof(TexelTuple));
+    Thread *threads = createTexelThreads(&limits);
+
+    if (fin == NULL) {
+        printf("Unable to open %s\n", TEXELFENS);
+        exit(EXIT_FAILURE);
+    }
 
-    // Initialize the thread for the search
-    thread->limits = &limits; thread->depth  = 0;
+    memset(data, 0, sizeof(TexelDataset));
 
-    // Create a TexelEntry for each FEN
-    for (i = 0; i < NPOSITIONS; i++) {
+    // Resolve the FENs one block at a time, stopping early when limited
+    while (!TexelPositions || data->npositions < TexelPositions) {
 
-        // Read next position from the FEN file
-        if (fgets(line, 128, fin) == NULL) {
-            printf("Unable to read line #%d\n", i);
-            exit(EXIT_FAILURE);
+        limit = TexelPositions ? MIN(READBATCH, TexelPositions - data->npositions) : READBATCH;
+        if (!(count = resolveTexelBlock(fin, threads, entries, tuples, limit)))
+            break;
+
+        // Grow the Entries and the Tuple arena geometrically as needed
+        if (data->npositions + count > entryCapacity) {
+            entryCapacity = MAX(2 * entryCapacity, data->npositions + count);
+            data->entries = realloc(data->entries, entryCapacity * sizeof(TexelBinaryEntry));
         }
 
-        // Occasional reporting for total completion
-        if ((i + 1) % 10000 == 0 || i == NPOSITIONS - 1)
-            printf("\rInitializing Texel Entries from FENS...  [%7d of %7d]", i + 1, NPOSITIONS);
-
-        // Determine the result of the game
-        if      (strstr(line, "1-0")) tes[i].result = 1.0;
-        else if (strstr(line, "0-1")) tes[i].result = 0.0;
-        else if (strstr(line, "1/2")) tes[i].result = 0.5;
-        else    {printf("Cannot Parse %s\n", line); exit(EXIT_FAILURE);}
-
-        // Resolve FEN to a quiet position
-        boardFromFEN(&thread->board, line);
-        qsearch(thread, &thread->pv, -MATE, MATE, 0);
-        for (j = 0; j < thread->pv.length; j++)
-            applyMove(&thread->board, thread->pv.line[j], undo);
-
-        // Determine the game phase based on remaining material
-        tes[i].phase = 24 - 4 * popcount(thread->board.pieces[QUEEN ])
-                          - 2 * popcount(thread->board.pieces[ROOK  ])
-                          - 1 * popcount(thread->board.pieces[BISHOP])
-                          - 1 * popcount(thread->board.pieces[KNIGHT]);
-
-        // Compute phase factors for updating the gradients and
-        tes[i].factors[MG] = 1 - tes[i].phase / 24.0;
-        tes[i].factors[EG] = 0 + tes[i].phase / 24.0;
-
-        // Finish the phase calculation for the evaluation
-        tes[i].phase = (tes[i].phase * 256 + 12) / 24.0;
-
-        // Vectorize the evaluation coefficients and save the eval
-        // relative to WHITE. We must first clear the coeff vector.
-        T = EmptyTrace;
-        tes[i].eval = evaluateBoard(&thread->board, NULL);
-        if (thread->board.turn == BLACK) tes[i].eval *= -1;
-        initCoefficients(coeffs);
-
-        // Count up the non zero coefficients
-        for (k = 0, j = 0; j < NTERMS; j++)
-            k += coeffs[j] != 0;
-
-        // Allocate Tuples
-        updateMemory(&tes[i], k);
-
-        // Initialize the Texel Tuples
-        for (k = 0, j = 0; j < NTERMS; j++) {
-            if (coeffs[j] != 0){
-                tes[i].tuples[k].index = j;
-                tes[i].tuples[k++].coeff = coeffs[j];
+        for (int i = 0; i < count; i++) {
+
+            if (data->ntuples + entries[i].ntuples > capacity) {
+                capacity = MAX(2 * capacity, data->ntuples + entries[i].ntuples);
+                data->tuples = realloc(data->tuples, capacity * sizeof(TexelTuple));
             }
+
+            memcpy(&data->tuples[data->ntuples], &tuples[i * NTERMS], entries[i].ntuples * sizeof(TexelTuple));
+            data->entries[data->npositions++] = entries[i];
+            data->ntuples += entries[i].ntuples;
+        }
+
+        printf("\rInitializing Texel Entries from FENS...  [%7d]", data->npositions);
+    }
+
+    // Release the unused space, leaving everything sized from the actual counts
+    data->entries = realloc(data->entries, data->npositions * sizeof(TexelBinaryEntry));
+    data->tuples  = realloc(data->tuples, data->ntuples * sizeof(TexelTuple));
+
+    deleteThreadPool(threads);
+    free(entries);
+    free(tuples);
+    fclose(fin);
+}
+
+void initTexelEntries(TexelEntry *tes, TexelDataset *data) {
+
+    TexelTuple *tuples = data->tuples;
+
+    // Each entry owns the next ntuples Tuples of the dataset
+    for (int i = 0; i < TexelPositions; i++) {
+        unpackTexelEntry(&tes[i], &data->entries[i], tuples);
+        tuples += data->entries[i].ntuples;
+    }
+}
+
+void initTexelTuples(TexelTuple *tuples, int coeffs[NTERMS]) {
+
+    // Save only the non zero coefficients, in order of their index
+    for (int i = 0; i < NTERMS; i++) {
+        if (coeffs[i] != 0) {
+            tuples->index = i;
+            (tuples++)->coeff = coeffs[i];
+        }
+    }
+}
+
+void resolveTexelPosition(Thread *thread, char *line, TexelBinaryEntry *entry, int coeffs[NTERMS]) {
+
+    Undo undo[1];
+
+    // Determine the result of the game, counted in half points
+    if      (strstr(line, "1-0")) entry->result = 2;
+    else if (strstr(line, "0-1")) entry->result = 0;
+    else if (strstr(line, "1/2")) entry->result = 1;
+    else    {printf("Cannot Parse %s\n", line); exit(EXIT_FAILURE);}
+
+    // Resolve FEN to a quiet position
+    boardFromFEN(&thread->board, line);
+    qsearch(thread, &thread->pv, -MATE, MATE, 0, 0);
+    for (int i = 0; i < thread->pv.length; i++)
+        applyMove(&thread->board, thread->pv.line[i], undo);
+
+    // Determine the game phase based on remaining material
+    entry->phase = 24 - 4 * popcount(thread->board.pieces[QUEEN ])
+                      - 2 * popcount(thread->board.pieces[ROOK  ])
+                      - 1 * popcount(thread->board.pieces[BISHOP])
+                      - 1 * popcount(thread->board.pieces[KNIGHT]);
+
+    // Vectorize the evaluation coefficients and save the eval
+    // relative to WHITE. We must first clear the coeff vector.
+    T = EmptyTrace;
+    entry->eval = evaluateBoard(&thread->board, NULL, NULL, NULL);
+    if (thread->board.turn == BLACK) entry->eval *= -1;
+    initCoefficients(coeffs);
+
+    // Count up the non zero coefficients
+    entry->ntuples = 0;
+    for (int i = 0; i < NTERMS; i++)
+        entry->ntuples += coeffs[i] != 0;
+}
+
+void unpackTexelEntry(TexelEntry *te, TexelBinaryEntry *entry, TexelTuple *tuples) {
+
+    te->result  = entry->result / 2.0;
+    te->eval    = entry->eval;
+    te->ntuples = entry->ntuples;
+    te->tuples  = tuples;
+
+    // Compute phase factors for updating the gradients
+    te->factors[MG] = 1 - entry->phase / 24.0;
+    te->factors[EG] = 0 + entry->phase / 24.0;
+
+    // Finish the phase calculation for the evaluation
+    te->phase = (entry->phase * 256 + 12) / 24.0;
+}
+
+void buildTexelBinary() {
+
+    int count;
+    Limits limits = {0};
+    TexelVector cparams = {0};
+    TexelBinaryHeader header = {0};
+    TexelBinaryEntry *entries = NULL;
+
+    FILE *fin  = fopen(TEXELFENS, "r");
+    FILE *fout = fopen(TEXELBINARY, "wb");
+
+    if (fin == NULL || fout == NULL) {
+        printf("Unable to open %s or %s\n", TEXELFENS, TEXELBINARY);
+        exit(EXIT_FAILURE);
+    }
+
+    // Quiescence searches only need a small Transposition Table
+    initTT(1);
+
+    // Each block of FENs is resolved into a fixed size Tuple buffer
+    TexelTuple *tuples = malloc(READBATCH * NTERMS * sizeof(TexelTuple));
+    Thread *threads = createTexelThreads(&limits);
+
+    // The header is rewritten with the final counts once we are done
+    memcpy(header.magic, TEXELMAGIC, sizeof(header.magic));
+    initCurrentParameters(cparams);
+    header.nterms   = NTERMS;
+    header.checksum = checksumParameters(cparams);
+    fwrite(&header, sizeof(header), 1, fout);
+
+    // Stream the tuples out as we go, keeping only the small entries in memory
+    while (1) {
+
+        entries = realloc(entries, (header.npositions + READBATCH) * sizeof(TexelBinaryEntry));
+        TexelBinaryEntry *block = &entries[header.npositions];
+
+        if (!(count = resolveTexelBlock(fin, threads, block, tuples, READBATCH)))
+            break;
+
+        // Write out the Tuples in order, dropping the unused space
+        for (int i = 0; i < count; i++) {
+            fwrite(&tuples[i * NTERMS], sizeof(TexelTuple), block[i].ntuples, fout);
+            header.ntuples += block[i].ntuples;
         }
+
+        header.npositions += count;
+        printf("\rResolving Texel Entries from FENS...  [%7d]", (int)header.npositions);
     }
 
+    fwrite(entries, sizeof(TexelBinaryEntry), header.npositions, fout);
+    fseek(fout, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fout);
+
+    printf("\rResolved %d Texel Entries with %"PRIu64" Tuples into %s\n",
+           (int)header.npositions, header.ntuples, TEXELBINARY);
+
+    deleteThreadPool(threads);
+    free(entries);
+    free(tuples);
     fclose(fin);
+    fclose(fout);
+}
+
+int loadTexelBinary(TexelDataset *data) {
+
+    struct stat st;
+    TexelBinaryHeader *header;
+    TexelVector cparams = {0};
+
+    // No binary dataset available, fall back to resolving the FENs
+    int fd = open(TEXELBINARY, O_RDONLY);
+    if (fd == -1) return 0;
+
+    if (fstat(fd, &st) == -1 || (size_t) st.st_size < sizeof(TexelBinaryHeader)) {
+        printf("\n\nUnable to read %s, rebuild it with ./Ethereal texelbinary\n", TEXELBINARY);
+        exit(EXIT_FAILURE);
+    }
+
+    // Map the entire file. Pages are only read in as they are first touched
+    data->size    = st.st_size;
+    data->mapping = mmap(NULL, data->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data->mapping == MAP_FAILED) {
+        printf("Unable to map %s\n", TEXELBINARY);
+        exit(EXIT_FAILURE);
+    }
+
+    header = (TexelBinaryHeader*) data->mapping;
+    initCurrentParameters(cparams);
+
+    if (   memcmp(header->magic, TEXELMAGIC, sizeof(header->magic))
+        || header->nterms != NTERMS
+        || header->checksum != checksumParameters(cparams)) {
+        printf("\n\n%s does not match this tuner, rebuild it with ./Ethereal texelbinary\n", TEXELBINARY);
+        exit(EXIT_FAILURE);
+    }
+
+    // A truncated file would otherwise be read past the end of the mapping
+    if (   header->ntuples > data->size / sizeof(TexelTuple)
+        || header->npositions > data->size / sizeof(TexelBinaryEntry)
+        || data->size != sizeof(TexelBinaryHeader)
+                       + header->ntuples * sizeof(TexelTuple)
+                       + header->npositions * sizeof(TexelBinaryEntry)) {
+        printf("\n\n%s is truncated or corrupt, rebuild it with ./Ethereal texelbinary\n", TEXELBINARY);
+        exit(EXIT_FAILURE);
+    }
+
+    // Use the first TexelPositions positions, or all of them if not limited
+    data->npositions = !TexelPositions ? (int) header->npositions
+                     : (int) MIN((uint64_t) TexelPositions, header->npositions);
+
+    data->tuples  = (TexelTuple*) (data->mapping + sizeof(TexelBinaryHeader));
+    data->entries = (TexelBinaryEntry*) (data->tuples + header->ntuples);
+
+    // Count only the Tuples which belong to the positions in use
+    data->ntuples = 0;
+    for (int i = 0; i < data->npositions; i++)
+        data->ntuples += data->entries[i].ntuples;
+
+    return 1;
+}
+
+void freeTexelDataset(TexelDataset *data) {
+
+    // Mapped datasets own no memory beyond the mapping itself
+    if (data->mapping != NULL)
+        munmap(data->mapping, data->size);
+
+    else {
+        free(data->entries);
+        free(data->tuples);
+    }
 }
 
 void initCoefficients(int coeffs[NTERMS]) {
@@ -251,55 +626,69 @@ void initCurrentParameters(TexelVector cparams) {
     }
 }
 
-void updateMemory(TexelEntry *te, int size) {
+uint64_t checksumParameters(TexelVector cparams) {
 
-    // First ensure we have enough Tuples left for this TexelEntry
-    if (size > TupleStackSize) {
-        printf("\n\nAllocating Memory for Texel Tuple Stack [%dKB]...\n\n",
-                (int)(STACKSIZE * sizeof(TexelTuple) / 1024));
-        TupleStackSize = STACKSIZE;
-        TupleStack = calloc(STACKSIZE, sizeof(TexelTuple));
-    }
+    // FNV-1a over the raw bytes of the parameters
+    uint64_t hash = 0xCBF29CE484222325ull;
+    const unsigned char *bytes = (const unsigned char*) cparams;
 
-    // Allocate Tuples for the given TexelEntry
-    te->tuples = TupleStack;
-    te->ntuples = size;
+    for (size_t i = 0; i < sizeof(TexelVector); i++)
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
 
-    // Update internal memory manager
-    TupleStack += size;
-    TupleStackSize -= size;
+    return hash;
 }
 
 void updateGradient(TexelEntry *tes, TexelVector gradient, TexelVector params, double K, int batch) {
 
-    int start = batch * BATCHSIZE;
-    int end   = start + BATCHSIZE;
+    int start = batch * TexelBatchSize;
+    int end   = start + TexelBatchSize;
+    int nthreads = omp_get_max_threads();
 
-    #pragma omp parallel shared(gradient)
+    // Single precision parameters and gradients for the inner loop, with one
+    // gradient per thread, which are summed in a fixed order once complete
+    TexelFloatVector fparams, *locals = calloc(nthreads, sizeof(TexelFloatVector));
+    const float scale = K * log(10.0) / 400.0;
+
+    for (int i = 0; i < NTERMS; i++)
+        for (int j = MG; j <= EG; j++)
+            fparams[i][j] = params[i][j];
+
+    #pragma omp parallel
     {
-        TexelVector local = {0};
-        #pragma omp for schedule(static, BATCHSIZE / NPARTITIONS)
+        TexelFloatVector *local = &locals[omp_get_thread_num()];
+
+        #pragma omp for schedule(static, MAX(1, TexelBatchSize / NPARTITIONS))
         for (int i = start; i < end; i++) {
 
-            double error = singleLinearError(&tes[i], params, K);
+            // Derivative of the squared error, up to a constant factor
+            float sigm  = 1.0f / (1.0f + expf(-scale * linearEvaluationFloat(&tes[i], fparams)));
+            float error = (tes[i].result - sigm) * sigm * (1.0f - sigm);
 
-            for (int j = 0; j < tes[i].ntuples; j++)
-                for (int k = MG; k <= EG; k++)
-                    local[tes[i].tuples[j].index][k] += error * tes[i].factors[k] * tes[i].tuples[j].coeff;
+            // Both phases of every term are updated together
+            float mg = error * tes[i].factors[MG];
+            float eg = error * tes[i].factors[EG];
+
+            for (int j = 0; j < tes[i].ntuples; j++) {
+                (*local)[tes[i].tuples[j].index][MG] += mg * tes[i].tuples[j].coeff;
+                (*local)[tes[i].tuples[j].index][EG] += eg * tes[i].tuples[j].coeff;
+            }
         }
+    }
 
+    for (int t = 0; t < nthreads; t++)
         for (int i = 0; i < NTERMS; i++)
             for (int j = MG; j <= EG; j++)
-                gradient[i][j] += local[i][j];
-    }
+                gradient[i][j] += locals[t][i][j];
+
+    free(locals);
 }
 
 void shuffleTexelEntries(TexelEntry *tes) {
 
-    for (int i = 0; i < NPOSITIONS; i++) {
+    for (int i = 0; i < TexelPositions; i++) {
 
-        int A = rand64() % NPOSITIONS;
-        int B = rand64() % NPOSITIONS;
+        int A = rand64() % TexelPositions;
+        int B = rand64() % TexelPositions;
 
         TexelEntry temp = tes[A];
         tes[A] = tes[B];
@@ -338,12 +727,12 @@ double completeEvaluationError(TexelEntry *tes, double K) {
 
     #pragma omp parallel shared(total)
     {
-        #pragma omp for schedule(static, NPOSITIONS / NPARTITIONS) reduction(+:total)
-        for (int i = 0; i < NPOSITIONS; i++)
+        #pragma omp for schedule(static, MAX(1, TexelPositions / NPARTITIONS)) reduction(+:total)
+        for (int i = 0; i < TexelPositions; i++)
             total += pow(tes[i].result - sigmoid(K, tes[i].eval), 2);
     }
 
-    return total / (double)NPOSITIONS;
+    return total / (double)TexelPositions;
 }
 
 double completeLinearError(TexelEntry *tes, TexelVector params, double K) {
@@ -352,18 +741,12 @@ double completeLinearError(TexelEntry *tes, TexelVector params, double K) {
 
     #pragma omp parallel shared(total)
     {
-        #pragma omp for schedule(static, NPOSITIONS / NPARTITIONS) reduction(+:total)
-        for (int i = 0; i < NPOSITIONS; i++)
+        #pragma omp for schedule(static, MAX(1, TexelPositions / NPARTITIONS)) reduction(+:total)
+        for (int i = 0; i < TexelPositions; i++)
             total += pow(tes[i].result - sigmoid(K, linearEvaluation(&tes[i], params)), 2);
     }
 
-    return total / (double)NPOSITIONS;
-}
-
-double singleLinearError(TexelEntry *te, TexelVector params, double K) {
-    double sigm = sigmoid(K, linearEvaluation(te, params));
-    double sigmprime = sigm * (1 - sigm);
-    return (te->result - sigm) * sigmprime;
+    return total / (double)TexelPositions;
 }
 
 double linearEvaluation(TexelEntry *te, TexelVector params) {
@@ -378,6 +761,18 @@ double linearEvaluation(TexelEntry *te, TexelVector params) {
     return te->eval + ((mg * (256 - te->phase) + eg * te->phase) / 256.0);
 }
 
+float linearEvaluationFloat(TexelEntry *te, TexelFloatVector params) {
+
+    float mg = 0, eg = 0;
+
+    for (int i = 0; i < te->ntuples; i++) {
+        mg += te->tuples[i].coeff * params[te->tuples[i].index][MG];
+        eg += te->tuples[i].coeff * params[te->tuples[i].index][EG];
+    }
+
+    return te->eval + ((mg * (256 - te->phase) + eg * te->phase) / 256.0f);
+}
+
 double sigmoid(double K, double S) {
     return 1.0 / (1.0 + pow(10.0, -K * S / 400.0));
 }
@@ -20,19 +20,33 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <stdio.h>
+
 #include "types.h"
 
+#define TEXELFENS   ("FENS")      // Text dataset of FENs and results
+#define TEXELBINARY ("FENS.bin")  // Resolved dataset, see buildTexelBinary()
+#define TEXELMAGIC  ("ETHTEXEL")  // Identifies the binary dataset format
+#define CHECKPOINT  ("TUNER.chk") // Tuner state, saved with each report
+#define TUNERMAGIC  ("ETHTUNER")  // Identifies the checkpoint format
+
 #define KPRECISION  (     10) // Iterations for computing K
 #define NPARTITIONS (     64) // Total thread partitions
 #define REPORTING   (      1) // How often to report progress
 #define NTERMS      (    588) // Total terms in the tuner
 
-#define LEARNING    (    0.1) // Learning rate
+#define READBATCH   (  16384) // FENs resolved per parallel block
+
+#define LEARNING    (    0.1) // Default learning rate
 #define LRDROPRATE  (      1) // Cut LR by this each failure
-#define BATCHSIZE   (   2048) // FENs per mini-batch
-#define NPOSITIONS  (7500000) // Total FENS in the book
+#define BATCHSIZE   (   2048) // Default FENs per mini-batch
 
-#define STACKSIZE ((int)((double) NPOSITIONS * NTERMS / 32))
+#define ADAMBETA1   (    0.9) // Adam decay for the gradient average
+#define ADAMBETA2   (  0.999) // Adam decay for the squared gradient average
+#define EPSILON     (   1e-8) // Avoids dividing by zero in Adam and AdaGrad
+
+enum { TEXEL_SGD, TEXEL_ADAGRAD, TEXEL_ADAM };
 
 #define TunePawnValue                   (1)
 #define TuneKnightValue                 (1)
@@ -80,27 +94,98 @@
 #define TuneThreatByPawnPush            (1)
 
 struct TexelTuple {
-    int index;
-    int coeff;
+    int16_t index;
+    int16_t coeff;
 };
 
 struct TexelEntry {
     int ntuples;
-    double result;
-    double eval, phase;
-    double factors[PHASE_NB];
+    float result;
+    float eval, phase;
+    float factors[PHASE_NB];
     TexelTuple* tuples;
 };
 
-typedef double TexelVector[NTERMS][PHASE_NB];
+// The binary dataset is laid out as a TexelBinaryHeader, followed by every
+// TexelTuple of every position, followed by one TexelBinaryEntry per position.
+// Each entry owns the next ntuples tuples, so the file can be used in place.
+// The saved evals depend on the evaluation, so the header holds a checksum
+// of the current parameters, and the file is rejected once they change
+
+typedef struct TexelBinaryHeader {
+    char magic[8];
+    uint32_t nterms;
+    uint32_t unused;
+    uint64_t checksum;
+    uint64_t npositions;
+    uint64_t ntuples;
+} TexelBinaryHeader;
+
+typedef struct TexelBinaryEntry {
+    int32_t eval;
+    uint16_t ntuples;
+    int8_t phase;
+    uint8_t result;
+} TexelBinaryEntry;
+
+// A resolved dataset, either mapped from TEXELBINARY, or resolved from the
+// FENs into memory. Either way the Tuples are stored back to back, exactly
+// sized, in the same order as the entries which own them
+
+typedef struct TexelDataset {
+    int npositions;
+    uint64_t ntuples;
+    TexelBinaryEntry *entries;
+    TexelTuple *tuples;
+    char *mapping;
+    size_t size;
+} TexelDataset;
 
-void runTexelTuning(Thread* thread);
+typedef double TexelVector[NTERMS][PHASE_NB];
+typedef float TexelFloatVector[NTERMS][PHASE_NB];
+
+// Everything needed to resume tuning, written to CHECKPOINT as is. The
+// params are deltas from the compiled in terms, so the checkpoint also
+// identifies those terms, the dataset, and the batch size it was made
+// with. The moment is used by Adam, and the velocity by both Adam and AdaGrad
+
+typedef struct TexelState {
+    char magic[8];
+    uint32_t nterms;
+    uint32_t optimizer;
+    uint64_t checksum;
+    uint64_t npositions;
+    uint64_t ntuples;
+    int batchsize;
+    int iteration, step;
+    double K, rate, best;
+    TexelVector params, moment, velocity;
+} TexelState;
+
+void runTexelTuning(int argc, char **argv);
+int parseTexelOptimizer(char *name);
+void updateParameters(TexelState *state, TexelVector gradient);
+void initTexelState(TexelState *state, TexelDataset *data, TexelVector cparams);
+void saveTexelCheckpoint(TexelState *state);
+int loadTexelCheckpoint(TexelState *state);
+
+Thread* createTexelThreads(Limits *limits);
+int resolveTexelBlock(FILE *fin, Thread *threads, TexelBinaryEntry *entries, TexelTuple *tuples, int max);
+
+void initTexelDataset(TexelDataset *data);
+void initTexelEntries(TexelEntry *tes, TexelDataset *data);
+void initTexelTuples(TexelTuple *tuples, int coeffs[NTERMS]);
+void resolveTexelPosition(Thread *thread, char *line, TexelBinaryEntry *entry, int coeffs[NTERMS]);
+void unpackTexelEntry(TexelEntry *te, TexelBinaryEntry *entry, TexelTuple *tuples);
+
+void buildTexelBinary();
+int loadTexelBinary(TexelDataset *data);
+void freeTexelDataset(TexelDataset *data);
 
-void initTexelEntries(TexelEntry *tes, Thread *thread);
 void initCoefficients(int coeffs[NTERMS]);
 void initCurrentParameters(TexelVector cparams);
+uint64_t checksumParameters(TexelVector cparams);
 
-void updateMemory(TexelEntry *te, int size);
 void updateGradient(TexelEntry *tes, TexelVector gradient, TexelVector params, double K, int batch);
 
 void shuffleTexelEntries(TexelEntry *tes);
@@ -108,8 +193,8 @@ void shuffleTexelEntries(TexelEntry *tes);
 double computeOptimalK(TexelEntry *tes);
 double completeEvaluationError(TexelEntry *tes, double K);
 double completeLinearError(TexelEntry *tes, TexelVector params, double K);
-double singleLinearError(TexelEntry *te, TexelVector params, double K);
 double linearEvaluation(TexelEntry *te, TexelVector params);
+float linearEvaluationFloat(TexelEntry *te, TexelFloatVector params);
 double sigmoid(double K, double S);
 
 void printParameters(TexelVector params, TexelVector cparams);
@@ -28,6 +28,10 @@
 #include "types.h"
 #include "windows.h"
 
+int PawnKingMegabytes = 2; // Size of each Thread's Pawn King Table
+
+int PawnKingShared = 0; // Use a single Pawn King Table for all Threads
+
 Thread* createThreadPool(int nthreads){
 
     Thread* threads = malloc(sizeof(Thread) * nthreads);
@@ -44,10 +48,20 @@ Thread* createThreadPool(int nthreads){
         threads[i].moveStack = &(threads[i]._moveStack[4]);
         threads[i].pieceStack = &(threads[i]._pieceStack[4]);
 
+        // Offset the hash stack so the game history sits before the root
+        threads[i].hashStack = &(threads[i]._hashStack[MAX_HISTORY]);
+
         // Zero out the stack, most importantly the first four slots
         memset(&threads[i]._evalStack, 0, sizeof(int) * (MAX_PLY + 4));
         memset(&threads[i]._moveStack, 0, sizeof(uint16_t) * (MAX_PLY + 4));
         memset(&threads[i]._pieceStack, 0, sizeof(int) * (MAX_PLY + 4));
+        memset(&threads[i].attackStack, 0, sizeof(AttackMaps) * (MAX_PLY + 1));
+        memset(&threads[i]._hashStack, 0, sizeof(uint64_t) * (MAX_HISTORY + MAX_PLY));
+
+        // Either allocate our own Pawn King Table, or use the first Thread's
+        if (PawnKingShared && i > 0)
+            sharePawnKingTable(&threads[i].pktable, &threads[0].pktable);
+        else initPawnKingTable(&threads[i].pktable, PawnKingMegabytes);
     }
 
     resetThreadPool(threads);
@@ -55,6 +69,14 @@ Thread* createThreadPool(int nthreads){
     return threads;
 }
 
+void deleteThreadPool(Thread* threads){
+
+    for (int i = 0; i < threads[0].nthreads; i++)
+        freePawnKingTable(&threads[i].pktable);
+
+    free(threads);
+}
+
 void resetThreadPool(Thread* threads){
 
     // Reset the per-thread tables, used for move ordering,
@@ -67,11 +89,18 @@ void resetThreadPool(Thread* threads){
         memset(&threads[i].cmhistory, 0, sizeof(CMHistoryTable  ));
         memset(&threads[i].fuhistory, 0, sizeof(FUHistoryTable  ));
         memset(&threads[i].cmtable,   0, sizeof(CounterMoveTable));
-        memset(&threads[i].pktable,   0, sizeof(PawnKingTable   ));
+        clearPawnKingTable(&threads[i].pktable);
+        memset(&threads[i].mtable,    0, sizeof(MaterialTable   ));
     }
 }
 
-void newSearchThreadPool(Thread* threads, Board* board, Limits* limits, SearchInfo* info){
+void newSearchThreadPool(Thread* threads, Board* board, uint64_t* history, int length, Limits* limits, SearchInfo* info){
+
+    // Only the most recent positions can matter for repetitions
+    if (length > MAX_HISTORY) {
+        history += length - MAX_HISTORY;
+        length = MAX_HISTORY;
+    }
 
     // Initialize each Thread in the Thread Pool
     for (int i = 0; i < threads[0].nthreads; i++){
@@ -85,10 +114,17 @@ void newSearchThreadPool(Thread* threads, Board* board, Limits* limits, SearchIn
         // Make our own copy of the original position
         memcpy(&threads[i].board, board, sizeof(Board));
 
+        // Place the game history just before the root, and clear anything
+        // older than it, so that it can never be matched as a repetition
+        memset(&threads[i]._hashStack, 0, sizeof(uint64_t) * (MAX_HISTORY - length));
+        if (length) memcpy(threads[i].hashStack - length, history, sizeof(uint64_t) * length);
+
         // Zero out our depth and stat tracking
         threads[i].depth  = 0;
         threads[i].nodes  = 0ull;
         threads[i].tbhits = 0ull;
+        threads[i].tbcacheHits = threads[i].tbcacheMisses = 0ull;
+        threads[i].pktable.hits = threads[i].pktable.probes = 0ull;
     }
 }
 
@@ -111,3 +147,35 @@ uint64_t tbhitsSearchedThreadPool(Thread* threads){
 
     return tbhits;
 }
+
+uint64_t tbcacheHitsThreadPool(Thread* threads){
+
+    uint64_t hits = 0ull;
+
+    for (int i = 0; i < threads[0].nthreads; i++)
+        hits += threads[i].tbcacheHits;
+
+    return hits;
+}
+
+uint64_t tbcacheMissesThreadPool(Thread* threads){
+
+    uint64_t misses = 0ull;
+
+    for (int i = 0; i < threads[0].nthreads; i++)
+        misses += threads[i].tbcacheMisses;
+
+    return misses;
+}
+
+double pkhitrateThreadPool(Thread* threads){
+
+    uint64_t hits = 0ull, probes = 0ull;
+
+    for (int i = 0; i < threads[0].nthreads; i++){
+        hits   += threads[i].pktable.hits;
+        probes += threads[i].pktable.probes;
+    }
+
+    return probes == 0ull ? 0.0 : 100.0 * hits / probes;
+}
@@ -22,6 +22,8 @@
 #include <setjmp.h>
 
 #include "board.h"
+#include "evaluate.h"
+#include "material.h"
 #include "search.h"
 #include "transposition.h"
 #include "types.h"
@@ -39,6 +41,8 @@ struct Thread {
     int seldepth;
     uint64_t nodes;
     uint64_t tbhits;
+    uint64_t tbcacheHits;
+    uint64_t tbcacheMisses;
 
     int *evalStack;
     int _evalStack[MAX_PLY+4];
@@ -49,8 +53,13 @@ struct Thread {
     int *pieceStack;
     int _pieceStack[MAX_PLY+4];
 
+    uint64_t *hashStack;
+    uint64_t _hashStack[MAX_HISTORY+MAX_PLY];
+
     Undo undoStack[MAX_PLY];
 
+    AttackMaps attackStack[MAX_PLY+1];
+
     jmp_buf jbuffer;
 
     int index;
@@ -63,17 +72,26 @@ struct Thread {
     FUHistoryTable fuhistory;
     CounterMoveTable cmtable;
     PawnKingTable pktable;
+    MaterialTable mtable;
 };
 
 
 Thread* createThreadPool(int nthreads);
 
+void deleteThreadPool(Thread* threads);
+
 void resetThreadPool(Thread* threads);
 
-void newSearchThreadPool(Thread* threads, Board* board, Limits* limits, SearchInfo* info);
+void newSearchThreadPool(Thread* threads, Board* board, uint64_t* history, int length, Limits* limits, SearchInfo* info);
 
 uint64_t nodesSearchedThreadPool(Thread* threads);
 
 uint64_t tbhitsSearchedThreadPool(Thread* threads);
 
+uint64_t tbcacheHitsThreadPool(Thread* threads);
+
+uint64_t tbcacheMissesThreadPool(Thread* threads);
+
+double pkhitrateThreadPool(Thread* threads);
+
 #endif
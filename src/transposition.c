@@ -147,14 +147,59 @@ void storeTTEntry(uint64_t hash, uint16_t move, int value, int eval, int depth,
     replace->hash16     = (uint16_t)hash16;
 }
 
-PawnKingEntry* getPawnKingEntry(PawnKingTable *pktable, uint64_t pkhash) {
-    PawnKingEntry *pkentry = &pktable->entries[pkhash >> 48];
-    return pkentry->pkhash == pkhash ? pkentry : NULL;
+void initPawnKingTable(PawnKingTable *pktable, uint64_t megabytes) {
+
+    uint64_t entries = 1ull;
+
+    // Scale down the table to the closest power of 2, at or below megabytes
+    while ((entries << 1) * sizeof(PawnKingEntry) <= megabytes << 20)
+        entries <<= 1;
+
+    pktable->entries  = malloc(entries * sizeof(PawnKingEntry));
+    pktable->hashMask = entries - 1u;
+    pktable->owner    = 1;
+
+    clearPawnKingTable(pktable);
+}
+
+void sharePawnKingTable(PawnKingTable *pktable, PawnKingTable *owner) {
+
+    // Point at the entries of another Thread, but keep our own statistics
+    pktable->entries  = owner->entries;
+    pktable->hashMask = owner->hashMask;
+    pktable->owner    = 0;
+    pktable->hits     = pktable->probes = 0ull;
+}
+
+void freePawnKingTable(PawnKingTable *pktable) {
+    if (pktable->owner) free(pktable->entries);
+}
+
+void clearPawnKingTable(PawnKingTable *pktable) {
+    if (pktable->owner) memset(pktable->entries, 0, sizeof(PawnKingEntry) * (pktable->hashMask + 1u));
+    pktable->hits = pktable->probes = 0ull;
+}
+
+int getPawnKingEntry(PawnKingTable *pktable, uint64_t pkhash, PawnKingEntry *pkentry) {
+
+    // Copy the entry out, since a shared table may be written to at any time
+    *pkentry = pktable->entries[pkhash & pktable->hashMask];
+    pktable->probes++;
+
+    // Entries are stored with the data xor'ed into the key, so that an entry
+    // torn by a concurrent write from another Thread will fail to validate
+    if ((pkentry->pkhash ^ pkentry->passed ^ (uint32_t)pkentry->eval) != pkhash)
+        return 0;
+
+    pktable->hits++;
+    return 1;
 }
 
 void storePawnKingEntry(PawnKingTable *pktable, uint64_t pkhash, uint64_t passed, int eval) {
-    PawnKingEntry *pkentry = &pktable->entries[pkhash >> 48];
-    pkentry->pkhash = pkhash;
+
+    PawnKingEntry *pkentry = &pktable->entries[pkhash & pktable->hashMask];
+
+    pkentry->pkhash = pkhash ^ passed ^ (uint32_t)eval;
     pkentry->passed = passed;
     pkentry->eval   = eval;
 }
@@ -57,7 +57,10 @@ struct PawnKingEntry {
 };
 
 struct PawnKingTable {
-    PawnKingEntry entries[0x10000];
+    PawnKingEntry *entries;
+    uint64_t hashMask;
+    uint64_t hits, probes;
+    int owner;
 };
 
 void initTT(uint64_t megabytes);
@@ -67,7 +70,11 @@ int hashfullTT();
 int getTTEntry(uint64_t hash, uint16_t *move, int *value, int *eval, int *depth, int *bound);
 void storeTTEntry(uint64_t hash, uint16_t move, int value, int eval, int depth, int bound);
 
-PawnKingEntry* getPawnKingEntry(PawnKingTable *pktable, uint64_t pkhash);
+void initPawnKingTable(PawnKingTable *pktable, uint64_t megabytes);
+void sharePawnKingTable(PawnKingTable *pktable, PawnKingTable *owner);
+void freePawnKingTable(PawnKingTable *pktable);
+void clearPawnKingTable(PawnKingTable *pktable);
+int getPawnKingEntry(PawnKingTable *pktable, uint64_t pkhash, PawnKingEntry *pkentry);
 void storePawnKingEntry(PawnKingTable *pktable, uint64_t pkhash, uint64_t passed, int eval);
 
 #endif
@@ -43,7 +43,8 @@ enum {
 
 enum {
     MAX_PLY = 128,
-    MAX_MOVES = 256
+    MAX_MOVES = 256,
+    MAX_HISTORY = 100
 };
 
 enum {
@@ -105,6 +106,9 @@ typedef struct TTBucket TTBucket;
 typedef struct TTable TTable;
 typedef struct PawnKingEntry PawnKingEntry;
 typedef struct PawnKingTable PawnKingTable;
+typedef struct MaterialEntry MaterialEntry;
+typedef struct MaterialTable MaterialTable;
+typedef struct AttackMaps AttackMaps;
 typedef struct Limits Limits;
 typedef struct ThreadsGo ThreadsGo;
 
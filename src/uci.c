@@ -24,15 +24,19 @@
 #include <string.h>
 
 #include "attacks.h"
+#include "bitbase.h"
 #include "board.h"
+#include "cpu.h"
 #include "evaluate.h"
 #include "fathom/tbprobe.h"
 #include "history.h"
 #include "masks.h"
 #include "move.h"
 #include "movegen.h"
+#include "perft.h"
 #include "psqt.h"
 #include "search.h"
+#include "syzygy.h"
 #include "texel.h"
 #include "thread.h"
 #include "time.h"
@@ -46,6 +50,14 @@ extern int MoveOverhead; // Defined by Time.c
 
 extern unsigned TB_PROBE_DEPTH; // Defined by Syzygy.c
 
+extern unsigned TB_PRELOAD_PIECES; // Defined by Syzygy.c
+
+extern int PawnKingMegabytes; // Defined by Thread.c
+
+extern int PawnKingShared; // Defined by Thread.c
+
+extern int QSearchChecks; // Defined by Search.c
+
 extern volatile int ABORT_SIGNAL; // For killing active search
 
 extern volatile int IS_PONDERING; // For swapping out of PONDER
@@ -56,6 +68,8 @@ pthread_mutex_t READYLOCK = PTHREAD_MUTEX_INITIALIZER;
 int main(int argc, char **argv) {
 
     Board board;
+    uint64_t history[MAX_HISTORY];
+    int length = 0;
     char str[8192], *ptr;
     ThreadsGo threadsgo;
     pthread_t pthreadsgo;
@@ -64,12 +78,27 @@ int main(int argc, char **argv) {
     int megabytes = argc > 4 ? atoi(argv[4]) : 16;
 
     // Initialize the core components of Ethereal
+    initCPU();
     initAttacks();
     initializePSQT();
     initMasks();
+    initKPK();
     initZobrist();
     initSearch();
 
+    // The tuner creates its own Threads and Table, and parses its own arguments
+    #ifdef TUNE
+        if (argc > 1 && stringEquals(argv[1], "texelbinary"))
+            buildTexelBinary();
+
+        else if (argc > 1 && stringEquals(argv[1], "tune"))
+            runTexelTuning(argc - 2, argv + 2);
+
+        else runTexelTuning(0, NULL);
+
+        exit(0);
+    #endif
+
     // Default to 16MB TT
     initTT(megabytes);
 
@@ -79,29 +108,45 @@ int main(int argc, char **argv) {
     // Build our Thread Pool, with default size of 1-thread
     Thread* threads = createThreadPool(nthreads);
 
-    #ifdef TUNE
-        runTexelTuning(threads);
-        exit(0);
-    #endif
-
     if (argc > 1 && stringEquals(argv[1], "bench")) {
+        QSearchChecks = argc > 5 ? atoi(argv[5]) : 0;
         runBenchmark(threads, argc > 2 ? atoi(argv[2]) : 0);
         return 0;
     }
 
+    if (argc > 2 && stringEquals(argv[1], "perftsuite"))
+        return runPerftSuite(argv[2], nthreads);
+
+    if (argc > 2 && stringEquals(argv[1], "tbstress"))
+        return runTablebaseStress(argv[2], nthreads);
+
+    if (argc > 1 && stringEquals(argv[1], "pickbench")) {
+        runMovePickerBenchmark(threads, argc > 2 ? atoi(argv[2]) : 100000);
+        return 0;
+    }
+
+    if (argc > 1 && stringEquals(argv[1], "evalbench")) {
+        runEvalBenchmark(argc > 2 ? atoi(argv[2]) : 100000);
+        return 0;
+    }
+
     while (1){
 
         getInput(str);
 
         if (stringEquals(str, "uci")){
-            printf("id name Ethereal " ETHEREAL_VERSION "\n");
+            printf("id name Ethereal " VERSION_ID " (%s)\n", CPUPathName);
             printf("id author Andrew Grant & Laldon\n");
             printf("option name Hash type spin default 16 min 1 max 65536\n");
             printf("option name Threads type spin default 1 min 1 max 2048\n");
             printf("option name MoveOverhead type spin default 100 min 0 max 10000\n");
             printf("option name SyzygyPath type string default <empty>\n");
             printf("option name SyzygyProbeDepth type spin default 0 min 0 max 127\n");
+            printf("option name SyzygyPreload type spin default 0 min 0 max 6\n");
             printf("option name Ponder type check default false\n");
+            printf("option name PawnHash type spin default 2 min 1 max 1024\n");
+            printf("option name PawnHashShared type check default false\n");
+            printf("option name QSearchChecks type check default false\n");
             printf("uciok\n");
             fflush(stdout);
         }
@@ -122,7 +167,7 @@ int main(int argc, char **argv) {
             }
 
             if (stringStartsWith(str, "setoption name Threads value ")){
-                free(threads);
+                deleteThreadPool(threads);
                 nthreads = atoi(str + strlen("setoption name Threads value "));
                 threads = createThreadPool(nthreads);
                 printf("info string set Threads to %d\n", nthreads);
@@ -135,7 +180,10 @@ int main(int argc, char **argv) {
 
             if (stringStartsWith(str, "setoption name SyzygyPath value ")){
                 ptr = str + strlen("setoption name SyzygyPath value ");
-                tb_init(ptr); printf("info string set SyzygyPath to %s\n", ptr);
+                tablebasesWaitForPreload();
+                tb_init(ptr); clearTablebaseCache();
+                printf("info string set SyzygyPath to %s\n", ptr);
+                tablebasesPreload();
             }
 
             if (stringStartsWith(str, "setoption name SyzygyProbeDepth value ")){
@@ -143,6 +191,31 @@ int main(int argc, char **argv) {
                 printf("info string set SyzygyProbeDepth to %u\n", TB_PROBE_DEPTH);
             }
 
+            if (stringStartsWith(str, "setoption name SyzygyPreload value ")){
+                TB_PRELOAD_PIECES = atoi(str + strlen("setoption name SyzygyPreload value "));
+                printf("info string set SyzygyPreload to %u\n", TB_PRELOAD_PIECES);
+                tablebasesPreload();
+            }
+
+            if (stringStartsWith(str, "setoption name PawnHash value ")){
+                deleteThreadPool(threads);
+                PawnKingMegabytes = atoi(str + strlen("setoption name PawnHash value "));
+                threads = createThreadPool(nthreads);
+                printf("info string set PawnHash to %dMB\n", PawnKingMegabytes);
+            }
+
+            if (stringStartsWith(str, "setoption name PawnHashShared value ")){
+                deleteThreadPool(threads);
+                PawnKingShared = stringEquals(str, "setoption name PawnHashShared value true");
+                threads = createThreadPool(nthreads);
+                printf("info string set PawnHashShared to %s\n", PawnKingShared ? "true" : "false");
+            }
+
+            if (stringStartsWith(str, "setoption name QSearchChecks value ")){
+                QSearchChecks = stringEquals(str, "setoption name QSearchChecks value true");
+                printf("info string set QSearchChecks to %s\n", QSearchChecks ? "true" : "false");
+            }
+
             fflush(stdout);
         }
 
@@ -152,12 +225,14 @@ int main(int argc, char **argv) {
         }
 
         else if (stringStartsWith(str, "position"))
-            uciPosition(str, &board);
+            uciPosition(str, &board, history, &length);
 
         else if (stringStartsWith(str, "go")){
             strncpy(threadsgo.str, str, 512);
             threadsgo.threads = threads;
             threadsgo.board = &board;
+            threadsgo.history = history;
+            threadsgo.length = length;
             pthread_create(&pthreadsgo, NULL, &uciGo, &threadsgo);
         }
 
@@ -173,8 +248,13 @@ int main(int argc, char **argv) {
         else if (stringEquals(str, "quit"))
             break;
 
+        else if (stringStartsWith(str, "perft divide")){
+            perftRoot(&board, atoi(str + strlen("perft divide ")), nthreads, 1);
+            fflush(stdout);
+        }
+
         else if (stringStartsWith(str, "perft")){
-            printf("%"PRIu64"\n", perft(&board, atoi(str + strlen("perft "))));
+            printf("%"PRIu64"\n", perftRoot(&board, atoi(str + strlen("perft ")), nthreads, 0));
             fflush(stdout);
         }
 
@@ -196,8 +276,10 @@ void* uciGo(void* vthreadsgo){
     pthread_mutex_lock(&READYLOCK);
 
     char* str       = ((ThreadsGo*)vthreadsgo)->str;
-    Board* board    = ((ThreadsGo*)vthreadsgo)->board;
-    Thread* threads = ((ThreadsGo*)vthreadsgo)->threads;
+    Board* board      = ((ThreadsGo*)vthreadsgo)->board;
+    Thread* threads   = ((ThreadsGo*)vthreadsgo)->threads;
+    uint64_t* history = ((ThreadsGo*)vthreadsgo)->history;
+    int length        = ((ThreadsGo*)vthreadsgo)->length;
 
     Limits limits; limits.start = start;
 
@@ -259,11 +341,14 @@ void* uciGo(void* vthreadsgo){
     limits.inc  = (board->turn == WHITE) ?  winc :  binc;
 
     // Execute search, return best and ponder moves
-    getBestMove(threads, board, &limits, &bestMove, &ponderMove);
+    getBestMove(threads, board, history, length, &limits, &bestMove, &ponderMove);
 
     // UCI spec does not want reports until out of pondering
     while (IS_PONDERING);
 
+    // Report how well the Pawn King Table(s) served this search
+    printf("info string pawnhash hitrate %.2f%%\n", pkhitrateThreadPool(threads));
+
     // Report best move (we should always have one)
     moveToString(bestMove, bestMoveStr);
     printf("bestmove %s ", bestMoveStr);
@@ -283,7 +368,7 @@ void* uciGo(void* vthreadsgo){
     return NULL;
 }
 
-void uciPosition(char* str, Board* board){
+void uciPosition(char* str, Board* board, uint64_t* history, int* length){
 
     int size;
     char* ptr;
@@ -292,6 +377,9 @@ void uciPosition(char* str, Board* board){
     Undo undo[1];
     uint16_t moves[MAX_MOVES];
 
+    // History is rebuilt from the moves given with the position
+    *length = 0;
+
     // Position is defined by a FEN string
     if (stringContains(str, "fen"))
         boardFromFEN(board, strstr(str, "fen") + strlen("fen "));
@@ -321,6 +409,12 @@ void uciPosition(char* str, Board* board){
         for (size -= 1; size >= 0; size--){
             moveToString(moves[size], test);
             if (stringEquals(move, test)){
+
+                // Keep only the most recent positions in the history
+                if (*length == MAX_HISTORY)
+                    memmove(history, history + 1, sizeof(uint64_t) * --(*length));
+
+                history[(*length)++] = board->hash;
                 applyMove(board, moves[size], undo);
                 break;
             }
@@ -330,20 +424,22 @@ void uciPosition(char* str, Board* board){
         while (*ptr == ' ') ptr++;
 
         // Reset move history whenever we reset the fifty move rule
-        if (board->fiftyMoveRule == 0) board->numMoves = 0;
+        if (board->fiftyMoveRule == 0) *length = 0;
     }
 }
 
 void uciReport(Thread* threads, int alpha, int beta, int value){
 
-    PVariation* pv  = &threads[0].pv;
-    int hashfull    = hashfullTT();
-    int depth       = threads[0].depth;
-    int seldepth    = threads[0].seldepth;
-    int elapsed     = elapsedTime(threads[0].info);
-    uint64_t nodes  = nodesSearchedThreadPool(threads);
-    uint64_t tbhits = tbhitsSearchedThreadPool(threads);
-    int nps         = (int)(1000 * (nodes / (1 + elapsed)));
+    PVariation* pv         = &threads[0].pv;
+    int hashfull           = hashfullTT();
+    int depth              = threads[0].depth;
+    int seldepth           = threads[0].seldepth;
+    int elapsed            = elapsedTime(threads[0].info);
+    uint64_t nodes         = nodesSearchedThreadPool(threads);
+    uint64_t tbhits        = tbhitsSearchedThreadPool(threads);
+    uint64_t tbcacheHits   = tbcacheHitsThreadPool(threads);
+    uint64_t tbcacheMisses = tbcacheMissesThreadPool(threads);
+    int nps                = (int)(1000 * (nodes / (1 + elapsed)));
 
     value = MAX(alpha, MIN(value, beta));
 
@@ -372,21 +468,22 @@ void uciReport(Thread* threads, int alpha, int beta, int value){
     }
 
     puts("");
+
+    // Report the WDL cache alongside tbhits, once we have probed at all
+    if (tbcacheHits + tbcacheMisses)
+        printf("info string tbcache hits %"PRIu64" misses %"PRIu64"\n",
+               tbcacheHits, tbcacheMisses);
+
     fflush(stdout);
 }
 
-void uciReportTBRoot(uint16_t move, unsigned wdl, unsigned dtz){
-
-    int score = wdl == TB_LOSS ? -MATE + MAX_PLY + dtz + 1
-              : wdl == TB_WIN  ?  MATE - MAX_PLY - dtz - 1 : 0;
+void uciReportTBRoot(unsigned wdl, int searched, int legal){
 
-    printf("info depth %d seldepth %d score cp %d time 0 "
-           "nodes 0 tbhits 1 nps 0 hashfull %d pv ",
-           MAX_PLY - 1, MAX_PLY - 1, score, 0);
+    char* result = wdl == TB_WIN  ? "win"
+                 : wdl == TB_LOSS ? "loss" : "draw";
 
-    char moveStr[6];
-    moveToString(move, moveStr);
-    puts(moveStr);
+    printf("info string syzygy root %s, searching %d of %d moves\n",
+           result, searched, legal);
     fflush(stdout);
 }
 
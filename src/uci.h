@@ -23,14 +23,6 @@
 
 #define VERSION_ID "11.28"
 
-#if defined(USE_PEXT)
-    #define ETHEREAL_VERSION VERSION_ID" (PEXT)"
-#elif defined(USE_POPCNT)
-    #define ETHEREAL_VERSION VERSION_ID" (POPCNT)"
-#else
-    #define ETHEREAL_VERSION VERSION_ID
-#endif
-
 struct Limits {
     int depthLimit;
     double timeLimit;
@@ -48,6 +40,8 @@ struct ThreadsGo {
     char str[512];
     Thread* threads;
     Board* board;
+    uint64_t* history;
+    int length;
 };
 
 void getInput(char* str);
@@ -56,8 +50,8 @@ int stringStartsWith(char* str, char* key);
 int stringContains(char* str, char* key);
 
 void* uciGo(void* vthreadgo);
-void uciPosition(char* str, Board* board);
+void uciPosition(char* str, Board* board, uint64_t* history, int* length);
 void uciReport(Thread* threads, int alpha, int beta, int value);
-void uciReportTBRoot(uint16_t move, unsigned wdl, unsigned dtz);
+void uciReportTBRoot(unsigned wdl, int searched, int legal);
 
 #endif
@@ -19,7 +19,10 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include "attacks.h"
+#include "bitboards.h"
 #include "castle.h"
+#include "move.h"
 #include "types.h"
 #include "zobrist.h"
 
@@ -28,6 +31,9 @@ uint64_t ZobristEnpassKeys[FILE_NB];
 uint64_t ZobristCastleKeys[0x10];
 uint64_t ZobristTurnKey;
 
+uint64_t CuckooKeys[0x2000];
+uint16_t CuckooMoves[0x2000];
+
 uint64_t rand64() {
 
     // http://vigna.di.unimi.it/ftp/papers/xorshift.pdf
@@ -55,28 +61,76 @@ void initZobrist() {
     for (int f = 0; f < FILE_NB; f++)
         ZobristEnpassKeys[f] = rand64();
 
-    // Init the Zobrist castle keys for each castle status
-    ZobristCastleKeys[WHITE_KING_RIGHTS ] = rand64();
-    ZobristCastleKeys[WHITE_QUEEN_RIGHTS] = rand64();
-    ZobristCastleKeys[BLACK_KING_RIGHTS ] = rand64();
-    ZobristCastleKeys[BLACK_QUEEN_RIGHTS] = rand64();
+    // Init the Zobrist castle keys for each individual castle right
+    uint64_t rights[4] = { rand64(), rand64(), rand64(), rand64() };
 
-    // Combine the Zobrist castle keys for all possible castling rights
+    // Combine the Zobrist castle keys for all possible castling rights. The
+    // individual keys are kept apart so that no right cancels itself out
     for (int cr = 0; cr < 0x10; cr++) {
 
+        ZobristCastleKeys[cr] = 0ull;
+
         if (cr & WHITE_KING_RIGHTS)
-            ZobristCastleKeys[cr] ^= ZobristCastleKeys[WHITE_KING_RIGHTS];
+            ZobristCastleKeys[cr] ^= rights[0];
 
         if (cr & WHITE_QUEEN_RIGHTS)
-            ZobristCastleKeys[cr] ^= ZobristCastleKeys[WHITE_QUEEN_RIGHTS];
+            ZobristCastleKeys[cr] ^= rights[1];
 
         if (cr & BLACK_KING_RIGHTS)
-            ZobristCastleKeys[cr] ^= ZobristCastleKeys[BLACK_KING_RIGHTS];
+            ZobristCastleKeys[cr] ^= rights[2];
 
         if (cr & BLACK_QUEEN_RIGHTS)
-            ZobristCastleKeys[cr] ^= ZobristCastleKeys[BLACK_QUEEN_RIGHTS];
+            ZobristCastleKeys[cr] ^= rights[3];
     }
 
     // Init the Zobrist key for side to move
     ZobristTurnKey = rand64();
+
+    initCuckoo();
+}
+
+void initCuckoo() {
+
+    // Insert the key change of every reversible move on an empty board,
+    // which is the pair of piece keys and the turn key. Pawn moves and
+    // captures can never lead back to an earlier position, so we skip them
+    for (int pt = KNIGHT; pt <= KING; pt++) {
+        for (int colour = WHITE; colour <= BLACK; colour++) {
+
+            int piece = makePiece(pt, colour);
+
+            for (int sq1 = 0; sq1 < SQUARE_NB; sq1++) {
+
+                uint64_t attacks = pt == KNIGHT ? knightAttacks(sq1)
+                                 : pt == BISHOP ? bishopAttacks(sq1, 0ull)
+                                 : pt == ROOK   ? rookAttacks(sq1, 0ull)
+                                 : pt == QUEEN  ? queenAttacks(sq1, 0ull)
+                                 :                kingAttacks(sq1);
+
+                for (int sq2 = sq1 + 1; sq2 < SQUARE_NB; sq2++) {
+
+                    if (!testBit(attacks, sq2))
+                        continue;
+
+                    uint16_t move = MoveMake(sq1, sq2, NORMAL_MOVE);
+                    uint64_t key  = ZobristKeys[piece][sq1]
+                                  ^ ZobristKeys[piece][sq2]
+                                  ^ ZobristTurnKey;
+
+                    // Cuckoo insertion, displacing any entry in the way into
+                    // its alternate slot, until we land in an empty slot
+                    for (int i = CuckooH1(key); move != NONE_MOVE; ) {
+
+                        uint64_t tempKey  = CuckooKeys[i];
+                        uint16_t tempMove = CuckooMoves[i];
+
+                        CuckooKeys[i]  = key;  key  = tempKey;
+                        CuckooMoves[i] = move; move = tempMove;
+
+                        i = (i == CuckooH1(key)) ? CuckooH2(key) : CuckooH1(key);
+                    }
+                }
+            }
+        }
+    }
 }
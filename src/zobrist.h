@@ -27,5 +27,12 @@ extern uint64_t ZobristEnpassKeys[FILE_NB];
 extern uint64_t ZobristCastleKeys[0x10];
 extern uint64_t ZobristTurnKey;
 
+extern uint64_t CuckooKeys[0x2000];
+extern uint16_t CuckooMoves[0x2000];
+
+#define CuckooH1(key) ((int)(((key) >>  0) & 0x1FFF))
+#define CuckooH2(key) ((int)(((key) >> 16) & 0x1FFF))
+
 uint64_t rand64();
 void initZobrist();
+void initCuckoo();